@@ -0,0 +1,327 @@
+#ifndef BELLMAN_FORD_HPP_
+#define BELLMAN_FORD_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+#include "stats.hpp"
+
+// Bellman-Ford engines on a CsrGraph for graphs with negative-weight edges,
+// e.g. arbitrage detection on -log(exchange rate) weights.
+// compared to bellman_ford_sssp, they work on flat arrays, stop as soon as
+// nothing changes, and return the negative cycle found instead of false.
+// three variants:
+// - bellman_ford: passes over all vertices.
+// - spfa: only relaxes the vertices whose distance changed, kept in a queue.
+// - parallel_bellman_ford: each pass relaxes the edge slots in parallel by an
+//   atomic min on the distances.
+//
+// src may be -1, in which case all vertices start at distance 0, as if from
+// a virtual source with a zero-weight edge to each vertex. the negative cycle
+// found is then anywhere in the graph instead of only reachable from src.
+// distances are assumed to stay within the int range.
+// the stats are in tree.stats. for the passes over all vertices,
+// frontier_sizes[i] is #relaxations of the pass i.
+
+struct BellmanFordResult {
+  // only meaningful if there's no negative cycle.
+  ShortestPathTree tree;
+  // a negative-weight cycle v0 -> v1 -> ... -> vk -> v0 reachable from src,
+  // listed without repeating v0. empty if there's none.
+  std::vector<int> negative_cycle;
+};
+
+// find a cycle in the parent pointers, i.e. the edges parent[v] -> v.
+// any such cycle is of negative weight, since relaxing along a non-negative
+// cycle never improves a distance.
+/// @return the cycle in the edge direction, or empty if there's none.
+std::vector<int> parent_cycle(const std::vector<int>& parent) {
+  const int n = static_cast<int>(parent.size());
+  // key: vertex, value: the vertex whose parent walk visited it first.
+  std::vector<int> walk(n, -1);
+  for (int s = 0; s < n; ++s) {
+    int x = s;
+    while (x != -1 && walk[x] == -1) {
+      walk[x] = s;
+      x = parent[x];
+    }
+    // the walk from s ran into itself.
+    if (x != -1 && walk[x] == s) {
+      std::vector<int> cycle;
+      int y = x;
+      do {
+        cycle.push_back(y);
+        y = parent[y];
+      } while (y != x);
+      std::reverse(cycle.begin(), cycle.end());
+      return cycle;
+    }
+  }
+  return {};
+}
+
+// dist/parent of a fresh search from src, or from the virtual source if src
+// is -1.
+void init_bellman_ford(const int n, const int src, std::vector<int>& dist,
+                       std::vector<int>& parent) {
+  dist.assign(n, src == -1 ? 0 : MAX_DIST);
+  parent.assign(n, -1);
+  if (src != -1) {
+    dist[src] = 0;
+  }
+}
+
+// one pass relaxing the edges of all vertices.
+/// @return true if any distance changed.
+bool bellman_ford_pass(const CsrGraph& g, std::vector<int>& dist,
+                       std::vector<int>& parent,
+                       [[maybe_unused]] AlgoStats& stats) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> weights = g.weights();
+
+  bool changed = false;
+  GRAPH_STATS(const uint64_t relaxed = stats.edges_relaxed;)
+  for (int v = 0; v < g.num_vertices(); ++v) {
+    if (dist[v] == MAX_DIST) {
+      continue;
+    }
+    GRAPH_STATS(stats.edges_scanned += offsets[v + 1] - offsets[v];)
+    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+      const int d = dist[v] + weights[i];
+      if (d < dist[targets[i]]) {
+        dist[targets[i]] = d;
+        parent[targets[i]] = v;
+        changed = true;
+        GRAPH_STATS(++stats.edges_relaxed;)
+      }
+    }
+  }
+  GRAPH_STATS(stats.add_frontier(stats.frontier_sizes.size(),
+                                 stats.edges_relaxed - relaxed);)
+  return changed;
+}
+
+// the negative cycle once the relaxation failed to converge in V - 1 passes.
+// keep relaxing until the parent pointers close a cycle, which they do since
+// a negative cycle is reachable.
+std::vector<int> extract_negative_cycle(const CsrGraph& g,
+                                        std::vector<int>& dist,
+                                        std::vector<int>& parent,
+                                        AlgoStats& stats) {
+  GRAPH_STATS(PhaseTimer timer(stats, "negative_cycle");)
+  std::vector<int> cycle = parent_cycle(parent);
+  for (int i = 0; cycle.empty() && i < g.num_vertices(); ++i) {
+    bellman_ford_pass(g, dist, parent, stats);
+    cycle = parent_cycle(parent);
+  }
+  return cycle;
+}
+
+BellmanFordResult make_bellman_ford_result(const CsrGraph& g, const int src,
+                                           std::vector<int>& dist,
+                                           std::vector<int>& parent,
+                                           const bool converged,
+                                           AlgoStats& stats) {
+  BellmanFordResult result;
+  if (!converged) {
+    result.negative_cycle = extract_negative_cycle(g, dist, parent, stats);
+  }
+  result.tree.stats = std::move(stats);
+  result.tree.src = src;
+  result.tree.dist = std::move(dist);
+  result.tree.parent = std::move(parent);
+  return result;
+}
+
+// this algo works as bellman_ford_sssp: up to V - 1 passes of relaxation, and
+// a V-th pass which still changes something tells a negative cycle. but it
+// stops at the first pass without a change, which is after #edges of the
+// longest shortest path + 1 passes, often far fewer than V.
+BellmanFordResult bellman_ford(const CsrGraph& g, const int src) {
+  const int n = g.num_vertices();
+  std::vector<int> dist;
+  std::vector<int> parent;
+  init_bellman_ford(n, src, dist, parent);
+  AlgoStats stats;
+
+  bool converged = false;
+  {
+    GRAPH_STATS(PhaseTimer timer(stats, "relax");)
+    for (int i = 0; i < n && !converged; ++i) {
+      converged = !bellman_ford_pass(g, dist, parent, stats);
+    }
+  }
+  return make_bellman_ford_result(g, src, dist, parent, converged, stats);
+}
+
+// shortest path faster algorithm (SPFA), i.e. queue-based Bellman-Ford.
+// this algo works as below:
+// (1) keep a FIFO queue of the vertices whose distance changed and hence whose
+//     edges need relaxing. initially, it holds the source.
+// (2) pop a vertex and relax its edges, pushing each improved vertex not
+//     already in the queue.
+// (3) stop when the queue is empty.
+// negative cycles are detected by
+// - the #edges of the tentative path to a vertex reaching V, which can't
+//   happen on a shortest path.
+// - a cycle in the parent pointers, checked every V relaxations, which usually
+//   catches the cycle long before the path length does.
+// the worst case is still O(V * E), but it touches only the changed part of
+// the graph and is typically close to linear.
+BellmanFordResult spfa(const CsrGraph& g, const int src) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> weights = g.weights();
+
+  const int n = g.num_vertices();
+  std::vector<int> dist;
+  std::vector<int> parent;
+  init_bellman_ford(n, src, dist, parent);
+
+  // key: vertex, value: #edges of its tentative path.
+  std::vector<int> path_len(n, 0);
+  std::vector<char> in_queue(n, 0);
+  std::deque<int> q;
+  if (src == -1) {
+    for (int v = 0; v < n; ++v) {
+      q.push_back(v);
+      in_queue[v] = 1;
+    }
+  } else {
+    q.push_back(src);
+    in_queue[src] = 1;
+  }
+
+  AlgoStats stats;
+  GRAPH_STATS(stats.heap_pushes = q.size();
+              PhaseTimer timer(stats, "relax");)
+  long long relaxations = 0;
+  while (!q.empty()) {
+    const int v = q.front();
+    q.pop_front();
+    in_queue[v] = 0;
+    GRAPH_STATS(++stats.heap_pops;
+                stats.edges_scanned += offsets[v + 1] - offsets[v];)
+    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+      const int w = targets[i];
+      const int d = dist[v] + weights[i];
+      if (d >= dist[w]) {
+        continue;
+      }
+      dist[w] = d;
+      parent[w] = v;
+      path_len[w] = path_len[v] + 1;
+      GRAPH_STATS(++stats.edges_relaxed;)
+      if (path_len[w] >= n || (++relaxations % n == 0 &&
+                               !parent_cycle(parent).empty())) {
+        GRAPH_STATS(timer.stop();)
+        return make_bellman_ford_result(g, src, dist, parent, false, stats);
+      }
+      if (!in_queue[w]) {
+        q.push_back(w);
+        in_queue[w] = 1;
+        GRAPH_STATS(++stats.heap_pushes;)
+      }
+    }
+  }
+  GRAPH_STATS(timer.stop();)
+  return make_bellman_ford_result(g, src, dist, parent, true, stats);
+}
+
+// edge-parallel Bellman-Ford.
+// each pass splits the edge slots into equal chunks, and each thread relaxes
+// the edges in its chunk by a CAS loop on the packed {dist, parent} of the
+// target. a thread may see distances lowered by others in the same pass,
+// which only speeds up the convergence, as in the sequential passes.
+BellmanFordResult parallel_bellman_ford(
+    const CsrGraph& g, const int src,
+    const int num_threads = hardware_threads()) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> weights = g.weights();
+
+  // {dist, parent} packed into one word so that both are updated by one CAS.
+  const auto pack = [](const int dist, const int parent) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(dist)) << 32 |
+           static_cast<uint32_t>(parent);
+  };
+  const auto dist_of = [](const uint64_t s) {
+    return static_cast<int>(static_cast<uint32_t>(s >> 32));
+  };
+
+  const int n = g.num_vertices();
+  const auto state = std::make_unique<std::atomic<uint64_t>[]>(n);
+  for (int v = 0; v < n; ++v) {
+    state[v].store(pack(src == -1 || v == src ? 0 : MAX_DIST, -1),
+                   std::memory_order_relaxed);
+  }
+
+  AlgoStats stats;
+  GRAPH_STATS(
+      std::vector<ThreadStats> thread_stats(std::max(1, num_threads));
+      PhaseTimer timer(stats, "relax");)
+  bool converged = false;
+  for (int pass = 0; pass < n && !converged; ++pass) {
+    std::atomic<bool> changed{false};
+    parallel_for(g.num_edges(), num_threads,
+                 [&](std::size_t begin, std::size_t end,
+                     [[maybe_unused]] const int t) {
+                   // the source vertex of the first edge slot in this chunk.
+                   int v = static_cast<int>(
+                       std::upper_bound(offsets.begin(), offsets.end(),
+                                        static_cast<int>(begin)) -
+                       offsets.begin() - 1);
+                   bool local_changed = false;
+                   for (std::size_t i = begin; i < end; ++i) {
+                     while (static_cast<std::size_t>(offsets[v + 1]) <= i) {
+                       ++v;
+                     }
+                     const int dist_to_v =
+                         dist_of(state[v].load(std::memory_order_relaxed));
+                     if (dist_to_v == MAX_DIST) {
+                       continue;
+                     }
+                     GRAPH_STATS(++thread_stats[t].stats.edges_scanned;)
+                     const int d = dist_to_v + weights[i];
+                     std::atomic<uint64_t>& s = state[targets[i]];
+                     uint64_t old = s.load(std::memory_order_relaxed);
+                     while (d < dist_of(old)) {
+                       if (s.compare_exchange_weak(old, pack(d, v),
+                                                   std::memory_order_relaxed)) {
+                         local_changed = true;
+                         GRAPH_STATS(++thread_stats[t].stats.edges_relaxed;)
+                         break;
+                       }
+                     }
+                   }
+                   if (local_changed) {
+                     changed.store(true, std::memory_order_relaxed);
+                   }
+                 });
+    converged = !changed.load(std::memory_order_relaxed);
+  }
+  GRAPH_STATS(timer.stop();
+              for (const ThreadStats& s : thread_stats) { stats += s.stats; })
+
+  std::vector<int> dist(n);
+  std::vector<int> parent(n);
+  for (int v = 0; v < n; ++v) {
+    const uint64_t s = state[v].load(std::memory_order_relaxed);
+    dist[v] = dist_of(s);
+    parent[v] = static_cast<int>(static_cast<uint32_t>(s));
+  }
+  return make_bellman_ford_result(g, src, dist, parent, converged, stats);
+}
+
+#endif  // BELLMAN_FORD_HPP_
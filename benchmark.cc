@@ -0,0 +1,674 @@
+// benchmarks of the algorithms on the synthetic graphs of generators.hpp.
+// standalone, no dependency beyond the headers of this repo:
+//   g++ -std=c++20 -O2 -pthread -I. benchmark.cc -o benchmark
+//   ./benchmark --generators rmat,grid --scale 18 --threads 1,2,4,8
+// for each workload and algorithm it reports the median time of the runs, the
+// throughput in million traversed edges per second (MTEPS, #edges of the
+// input / time, the Graph500 convention) and the peak heap memory allocated
+// during a run on top of the input. the parallel variants run once per
+// #threads, along with their speedup over the first #threads given.
+//
+// the point-to-point searches, i.e. bidirectional Dijkstra, A* with ALT and
+// the contraction hierarchy, answer a batch of QUERIES random pairs per run,
+// and so do the query executor and the path cache. their MTEPS is #edges /
+// time of the whole batch, comparable between them only. the preprocessing
+// of ALT and of the CH query runs once per workload, outside of the runs, and
+// the CH build is a benchmark of its own. the CH runs on grid only, the road
+// network-like workload it's meant for. the APSPs run on a workload of the
+// same generator at scale min(S, APSP_SCALE), since they cost O(V^3) and
+// O(V E log V). the topological sorts run on the DAG of the edges oriented
+// from the lower to the higher id, and the DynamicTopologicalOrder loads all
+// but the last 1 / DYNAMIC_SHARE of them at once and inserts the rest.
+//
+// not benchmarked:
+// - floyd_warshall_apsp of shortest_path.hpp, on Graph: hash map based and
+//   printing, it's the reference of blocked_floyd_warshall, not a contender.
+// - kruskal_max_span_tree: kruskal_min_span_tree with the order reversed.
+// - graph_file.hpp: I/O, bound by the disk rather than the algorithm.
+// - the infrastructure headers, i.e. id_map, indexed_heap, workspace, stats,
+//   parallel, thread_pool and shortest_path_tree: exercised through the
+//   algorithms that build on them.
+//
+// options:
+//   --generators LIST   comma separated among rmat, er, grid, chain. all.
+//   --scale S           about 2^S vertices per workload. 16.
+//   --edge-factor F     #edges per vertex of rmat and er. 16.
+//   --threads LIST      comma separated #threads of the parallel variants.
+//                       1, 2, 4, ... up to the #hardware threads.
+//   --repeats R         runs per measurement. 3.
+//   --filter SUBSTR     only the algorithms whose name contains SUBSTR.
+//   --seed N            seed of the generators. 1.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bellman_ford.hpp"
+#include "bfs.hpp"
+// no header of its own, and no main.
+#include "bipartile_graph_check.cc"
+#include "connected_components.hpp"
+#include "contraction_hierarchies.hpp"
+#include "csr_graph.hpp"
+#include "delta_stepping.hpp"
+#include "dijkstra_engine.hpp"
+#include "directed_cycle_detection.hpp"
+#include "dynamic_connectivity.hpp"
+#include "dynamic_topological_order.hpp"
+#include "floyd_warshall.hpp"
+#include "generators.hpp"
+#include "graph.hpp"
+#include "johnson.hpp"
+#include "minimum_spanning_tree.hpp"
+#include "ms_bfs.hpp"
+#include "parallel.hpp"
+#include "point_to_point.hpp"
+#include "query_executor.hpp"
+#include "reordering.hpp"
+#include "shortest_path.hpp"
+#include "shortest_path_cache.hpp"
+#include "streaming_connected_components.hpp"
+#include "strongly_connected_components.hpp"
+#include "topological_sorting.hpp"
+#include "undirected_cycle_detection.hpp"
+
+// heap accounting by replacing the global operator new and delete.
+// each block is prefixed with its size so that delete can subtract it.
+// the counters are atomic since the parallel variants allocate concurrently.
+std::atomic<std::size_t> live_bytes{0};
+std::atomic<std::size_t> peak_bytes{0};
+
+// the prefix before a block of the alignment, a multiple of it so that the
+// block stays aligned. the size is kept in its last bytes.
+std::size_t header_size(const std::size_t alignment) {
+  return std::max(alignment, alignof(std::max_align_t));
+}
+
+void* allocate(const std::size_t size, const std::size_t alignment) {
+  const std::size_t header = header_size(alignment);
+  // aligned_alloc wants a multiple of the alignment.
+  const std::size_t total =
+      (header + size + alignment - 1) / alignment * alignment;
+  char* const base = static_cast<char*>(std::aligned_alloc(alignment, total));
+  if (base == nullptr) {
+    throw std::bad_alloc();
+  }
+  char* const p = base + header;
+  reinterpret_cast<std::size_t*>(p)[-1] = size;
+  const std::size_t live = live_bytes.fetch_add(size) + size;
+  std::size_t peak = peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {
+  }
+  return p;
+}
+
+// not inlined into the operators, or gcc sees the free of a pointer from
+// operator new and warns of a mismatch.
+[[gnu::noinline]] void deallocate(void* const p,
+                                  const std::size_t alignment) {
+  if (p == nullptr) {
+    return;
+  }
+  live_bytes.fetch_sub(static_cast<std::size_t*>(p)[-1]);
+  std::free(static_cast<char*>(p) - header_size(alignment));
+}
+
+constexpr std::size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+void* operator new(std::size_t size) {
+  return allocate(size, DEFAULT_ALIGNMENT);
+}
+void* operator new[](std::size_t size) {
+  return allocate(size, DEFAULT_ALIGNMENT);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size, DEFAULT_ALIGNMENT);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return operator new(size, std::nothrow);
+}
+void operator delete(void* p) noexcept { deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete[](void* p) noexcept { deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete(void* p, std::size_t) noexcept {
+  deallocate(p, DEFAULT_ALIGNMENT);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+  deallocate(p, DEFAULT_ALIGNMENT);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  deallocate(p, DEFAULT_ALIGNMENT);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  deallocate(p, DEFAULT_ALIGNMENT);
+}
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+  deallocate(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+  deallocate(p, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p, std::size_t,
+                     std::align_val_t alignment) noexcept {
+  deallocate(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* p, std::size_t,
+                       std::align_val_t alignment) noexcept {
+  deallocate(p, static_cast<std::size_t>(alignment));
+}
+
+struct Options {
+  std::vector<std::string> generators{"rmat", "er", "grid", "chain"};
+  int scale{16};
+  int edge_factor{16};
+  std::vector<int> threads;
+  int repeats{3};
+  std::string filter;
+  uint64_t seed{1};
+};
+
+// #source-sink pairs per run of the point-to-point searches.
+constexpr int QUERIES = 64;
+// #distinct sources among the queries of the path cache.
+constexpr int CACHE_SOURCES = 4;
+// the max scale of the APSP workload.
+constexpr int APSP_SCALE = 10;
+// #landmarks of ALT.
+constexpr int LANDMARKS = 16;
+// 1 / the share of the DAG edges inserted one by one into the
+// DynamicTopologicalOrder, after a bulk load of the others.
+constexpr int DYNAMIC_SHARE = 64;
+
+// one input graph in all the forms the algorithms take.
+struct Workload {
+  std::string name;
+  // directed.
+  Graph graph;
+  CsrGraph csr;
+  // csr.reversed(), for the searches that also walk the edges backwards.
+  CsrGraph reversed_csr;
+  // the underlying undirected graph, for CC and MST.
+  UndirectedGraph undirected_graph;
+  CsrGraph undirected_csr;
+  // each undirected edge once, as dense indices of undirected_csr.
+  std::vector<Edge> undirected_edges;
+  // the edges oriented from the lower to the higher id, i.e. a DAG, and
+  // shuffled, for the topological sorts.
+  std::vector<Edge> dag_edges;
+  CsrGraph dag;
+  // all but the last 1 / DYNAMIC_SHARE of dag_edges.
+  Graph dag_prefix;
+  // the same generator at scale min(S, APSP_SCALE), for the APSPs.
+  CsrGraph small;
+  // the source of the SSSPs, as an id and as a dense index.
+  int src;
+  int src_index;
+  // random source-sink pairs of dense indices of csr.
+  std::vector<PathQuery> queries;
+  // built by the prepare step of the benchmarks that need them.
+  std::optional<LandmarkHeuristic> landmarks;
+  std::optional<ContractionHierarchy> ch;
+  std::optional<Permutation> permutation;
+};
+
+// the graph whose V and E a benchmark reports.
+enum class Input {
+  directed,
+  undirected,
+  dag,
+  small,
+};
+
+struct Benchmark {
+  std::string name;
+  // run once per #threads if true, once otherwise.
+  bool parallel;
+  Input input;
+  // may reuse and update what prepare built, e.g. the target of a heuristic.
+  std::function<void(Workload&, int)> run;
+  // untimed, once per workload before the runs, if set.
+  std::function<void(Workload&)> prepare{};
+  // only on this generator, if set.
+  std::string only_on{};
+};
+
+struct Measurement {
+  double seconds;
+  std::size_t peak_bytes;
+};
+
+std::vector<Edge> generate(const std::string& generator, const Options& o) {
+  const int n = 1 << o.scale;
+  if (generator == "rmat") {
+    return rmat_edges(o.scale, o.edge_factor, o.seed);
+  }
+  if (generator == "er") {
+    return erdos_renyi_edges(n, static_cast<std::size_t>(n) * o.edge_factor,
+                             o.seed);
+  }
+  if (generator == "grid") {
+    const int side = 1 << (o.scale / 2);
+    return grid_edges(side, n / side, o.seed);
+  }
+  if (generator == "chain") {
+    return chain_edges(n, o.seed);
+  }
+  std::cerr << "unknown generator " << generator << '\n';
+  std::exit(1);
+}
+
+// the first of the dag_edges inserted one by one.
+std::size_t dynamic_begin(const Workload& w) {
+  return w.dag_edges.size() - w.dag_edges.size() / DYNAMIC_SHARE;
+}
+
+Workload make_workload(const std::string& generator, const Options& o) {
+  const std::vector<Edge> edges = generate(generator, o);
+  Options small_options = o;
+  small_options.scale = std::min(o.scale, APSP_SCALE);
+  Workload w{.name = generator + "-" + std::to_string(o.scale),
+             .graph = {},
+             .csr = CsrGraph(edges),
+             .reversed_csr = CsrGraph(std::vector<Edge>{}),
+             .undirected_graph = {},
+             .undirected_csr = CsrGraph(std::vector<Edge>{}),
+             .undirected_edges = {},
+             .dag_edges = {},
+             .dag = CsrGraph(std::vector<Edge>{}),
+             .dag_prefix = {},
+             .small = CsrGraph(generate(generator, small_options)),
+             .src = 0,
+             .src_index = 0,
+             .queries = {},
+             .landmarks = {},
+             .ch = {},
+             .permutation = {}};
+  for (const Edge& e : edges) {
+    w.graph.add_edge(e);
+    w.undirected_graph.add_edge(e);
+    if (e.v != e.w) {
+      w.dag_edges.push_back(e.v < e.w ? e : Edge::make(e.w, e.v, e.weight));
+    }
+  }
+  w.reversed_csr = w.csr.reversed();
+  // the grid is symmetric already.
+  w.undirected_csr =
+      CsrGraph(generator == "grid" ? edges : symmetrized(edges));
+  w.undirected_edges = undirected_edge_list(w.undirected_csr);
+  std::mt19937_64 rng(o.seed);
+  std::shuffle(w.dag_edges.begin(), w.dag_edges.end(), rng);
+  w.dag = CsrGraph(w.dag_edges);
+  for (std::size_t i = 0; i < dynamic_begin(w); ++i) {
+    w.dag_prefix.add_edge(w.dag_edges[i]);
+  }
+  // the vertex of the max out-degree, so that the SSSPs reach a large part
+  // of the graph even if it's not strongly connected.
+  for (int v = 0; v < w.csr.num_vertices(); ++v) {
+    if (w.csr.degree(v) > w.csr.degree(w.src_index)) {
+      w.src_index = v;
+    }
+  }
+  w.src = w.csr.id(w.src_index);
+  std::uniform_int_distribution<int> vertex(0, w.csr.num_vertices() - 1);
+  for (int i = 0; i < QUERIES; ++i) {
+    const int s = vertex(rng);
+    w.queries.push_back(PathQuery{.src = s, .dst = vertex(rng)});
+  }
+  return w;
+}
+
+// the algorithms under test. the Graph based SSSPs stop at dst, so they are
+// given dst = -1, i.e. no vertex, to compute the whole tree.
+std::vector<Benchmark> benchmarks() {
+  return {
+      {"bfs_sssp", false, Input::directed,
+       [](const Workload& w, int) { bfs_sssp(w.graph, w.src, -1); }},
+      {"dijkstra_sssp", false, Input::directed,
+       [](const Workload& w, int) { dijkstra_sssp(w.graph, w.src, -1); }},
+      {"bellman_ford_sssp", false, Input::directed,
+       [](const Workload& w, int) {
+         // it relaxes all edges whatever the dst, which must be a vertex.
+         bellman_ford_sssp(w.graph, w.src, w.src);
+       }},
+      {"kruskal_min_span_tree", false, Input::undirected,
+       [](const Workload& w, int) {
+         kruskal_min_span_tree(w.undirected_graph);
+       }},
+      {"prim_min_span_tree", false, Input::undirected,
+       [](const Workload& w, int) {
+         prim_min_span_tree(w.undirected_graph);
+       }},
+      {"kosaraju_scc", false, Input::directed,
+       [](const Workload& w, int) { kosaraju_scc(w.graph); }},
+      {"dfs_connected_components", false, Input::undirected,
+       [](const Workload& w, int) {
+         dfs_connected_components(w.undirected_graph);
+       }},
+      {"uf_connected_components", false, Input::undirected,
+       [](const Workload& w, int) {
+         uf_connected_components(w.undirected_graph);
+       }},
+      {"DijkstraEngine", false, Input::directed,
+       [](const Workload& w, int) {
+         DijkstraEngine(w.csr).run(w.src_index);
+       }},
+      {"bellman_ford", false, Input::directed,
+       [](const Workload& w, int) { bellman_ford(w.csr, w.src_index); }},
+      {"spfa", false, Input::directed,
+       [](const Workload& w, int) { spfa(w.csr, w.src_index); }},
+      {"parallel_bfs", true, Input::directed,
+       [](const Workload& w, const int t) {
+         parallel_bfs(w.csr, w.src_index, t);
+       }},
+      {"delta_stepping_sssp", true, Input::directed,
+       [](const Workload& w, const int t) {
+         delta_stepping_sssp(w.csr, w.src_index, 0, t);
+       }},
+      {"parallel_bellman_ford", true, Input::directed,
+       [](const Workload& w, const int t) {
+         parallel_bellman_ford(w.csr, w.src_index, t);
+       }},
+      {"pearce_scc", true, Input::directed,
+       [](const Workload& w, const int t) { pearce_scc(w.csr, t); }},
+      {"parallel_scc", true, Input::directed,
+       [](const Workload& w, const int t) { parallel_scc(w.csr, t); }},
+      {"parallel_uf_connected_components", true, Input::undirected,
+       [](const Workload& w, const int t) {
+         parallel_uf_connected_components(w.undirected_csr, t);
+       }},
+      {"filter_kruskal_mst", true, Input::undirected,
+       [](const Workload& w, const int t) {
+         filter_kruskal_mst(w.undirected_edges,
+                            w.undirected_csr.num_vertices(), t);
+       }},
+      {"parallel_boruvka_mst", true, Input::undirected,
+       [](const Workload& w, const int t) {
+         parallel_boruvka_mst(w.undirected_edges,
+                              w.undirected_csr.num_vertices(), t);
+       }},
+      {"DijkstraEngine_queries", false, Input::directed,
+       [](const Workload& w, int) {
+         DijkstraEngine engine(w.csr);
+         for (const PathQuery& q : w.queries) {
+           engine.run(q.src, std::span<const int>(&q.dst, 1));
+         }
+       }},
+      {"BidirectionalDijkstra_queries", false, Input::directed,
+       [](const Workload& w, int) {
+         BidirectionalDijkstra search(w.csr, w.reversed_csr);
+         for (const PathQuery& q : w.queries) {
+           search.shortest_path(q.src, q.dst);
+         }
+       }},
+      {"AStarEngine_alt_queries", false, Input::directed,
+       [](Workload& w, int) {
+         AStarEngine engine(w.csr);
+         for (const PathQuery& q : w.queries) {
+           w.landmarks->set_target(q.dst);
+           engine.shortest_path(q.src, q.dst, *w.landmarks);
+         }
+       },
+       [](Workload& w) {
+         w.landmarks.emplace(w.csr, w.reversed_csr, LANDMARKS);
+       }},
+      {"ContractionHierarchy::build", true, Input::directed,
+       [](const Workload& w, const int t) {
+         ContractionHierarchy::build(w.csr, t);
+       },
+       {}, "grid"},
+      {"ChQuery_queries", false, Input::directed,
+       [](const Workload& w, int) {
+         ChQuery query(*w.ch);
+         for (const PathQuery& q : w.queries) {
+           query.shortest_path(q.src, q.dst);
+         }
+       },
+       [](Workload& w) { w.ch = ContractionHierarchy::build(w.csr); }, "grid"},
+      {"QueryExecutor_queries", true, Input::directed,
+       [](const Workload& w, const int t) {
+         QueryExecutor(w.csr, t).run(w.queries);
+       }},
+      {"ShortestPathCache_queries", false, Input::directed,
+       [](const Workload& w, int) {
+         // a cold cache, whose misses are the first query of each source.
+         ShortestPathCache cache(std::size_t{1} << 30);
+         for (int i = 0; i < QUERIES; ++i) {
+           const int src = w.queries[i % CACHE_SOURCES].src;
+           cache.shortest_path(w.graph, w.csr.id(src),
+                               w.csr.id(w.queries[i].dst));
+         }
+       }},
+      {"blocked_floyd_warshall", true, Input::small,
+       [](const Workload& w, const int t) {
+         blocked_floyd_warshall(w.small, false, t);
+       }},
+      {"johnson_apsp", true, Input::small,
+       [](const Workload& w, const int t) {
+         johnson_apsp(w.small, [](auto&&...) {}, t);
+       }},
+      {"MultiSourceBfs", true, Input::directed,
+       [](const Workload& w, const int t) {
+         std::vector<int> sources;
+         for (const PathQuery& q : w.queries) {
+           sources.push_back(q.src);
+         }
+         MultiSourceBfs<1>(w.csr, w.reversed_csr, t)
+             .run_batch(sources, [](auto&&...) {});
+       }},
+      {"dfs_topological_sorting", false, Input::dag,
+       [](const Workload& w, int) { dfs_topological_sorting(w.dag); }},
+      {"bfs_topological_sorting", false, Input::dag,
+       [](const Workload& w, int) { bfs_topological_sorting(w.dag); }},
+      {"parallel_topological_sorting", true, Input::dag,
+       [](const Workload& w, const int t) {
+         parallel_topological_sorting(w.dag, t);
+       }},
+      {"DynamicTopologicalOrder", false, Input::dag,
+       [](const Workload& w, int) {
+         // from scratch, each insertion in random order moves a window of
+         // O(V) vertices, so only a tail of updates is streamed.
+         DynamicTopologicalOrder order(w.dag_prefix);
+         for (std::size_t i = dynamic_begin(w); i < w.dag_edges.size(); ++i) {
+           order.add_edge(w.dag_edges[i]);
+         }
+       }},
+      // no cycle in the DAG, so it traverses the whole graph.
+      {"dfs_find_cycle", false, Input::dag,
+       [](const Workload& w, int) { dfs_find_cycle(w.dag); }},
+      {"dfs_find_undirected_cycle", false, Input::undirected,
+       [](const Workload& w, int) {
+         dfs_find_undirected_cycle(w.undirected_graph);
+       }},
+      {"uf_detect_cycle", false, Input::undirected,
+       [](const Workload& w, int) { uf_detect_cycle(w.undirected_graph); }},
+      {"parallel_uf_detect_cycle", true, Input::undirected,
+       [](const Workload& w, const int t) {
+         parallel_uf_detect_cycle(w.undirected_csr, t);
+       }},
+      {"alter_two_color_bipartile_graph_check", false, Input::undirected,
+       [](const Workload& w, int) {
+         alter_two_color_bipartile_graph_check(w.undirected_csr);
+       }},
+      {"parallel_bipartite_check", true, Input::undirected,
+       [](const Workload& w, const int t) {
+         parallel_bipartite_check(w.undirected_csr, t);
+       }},
+      {"StreamingConnectedComponents", false, Input::undirected,
+       [](const Workload& w, int) {
+         StreamingConnectedComponents cc;
+         cc.reserve(w.undirected_csr.num_vertices());
+         cc.add_edges(w.undirected_edges);
+       }},
+      {"OfflineDynamicConnectivity", false, Input::undirected,
+       [](const Workload& w, int) {
+         // insert all edges, then delete every other one, with a query per
+         // 64 updates.
+         OfflineDynamicConnectivity dc;
+         const std::vector<Edge>& edges = w.undirected_edges;
+         for (std::size_t i = 0; i < edges.size(); ++i) {
+           dc.add_edge(edges[i]);
+           if (i % 64 == 0) {
+             dc.query_connected(edges[i].v, edges[edges.size() - 1 - i].w);
+           }
+         }
+         for (std::size_t i = 0; i < edges.size(); i += 2) {
+           dc.remove_edge(edges[i].v, edges[i].w);
+           if (i % 64 == 0) {
+             dc.query_cc_cnt();
+           }
+         }
+         dc.solve();
+       }},
+      {"rcm_order", false, Input::directed,
+       [](const Workload& w, int) { rcm_order(w.csr); }},
+      {"degree_order", true, Input::directed,
+       [](const Workload& w, const int t) { degree_order(w.csr, t); }},
+      {"community_order", false, Input::directed,
+       [](const Workload& w, int) { community_order(w.csr); }},
+      {"permute", true, Input::directed,
+       [](const Workload& w, const int t) {
+         permute(w.csr, *w.permutation, t);
+       },
+       [](Workload& w) { w.permutation = rcm_order(w.csr); }},
+  };
+}
+
+const CsrGraph& input_of(const Workload& w, const Input input) {
+  switch (input) {
+    case Input::undirected:
+      return w.undirected_csr;
+    case Input::dag:
+      return w.dag;
+    case Input::small:
+      return w.small;
+    case Input::directed:
+      break;
+  }
+  return w.csr;
+}
+
+// the median time and the max peak memory of the runs.
+Measurement measure(const Benchmark& b, Workload& w, const int threads,
+                    const int repeats) {
+  std::vector<double> seconds;
+  std::size_t peak = 0;
+  for (int i = 0; i < repeats; ++i) {
+    const std::size_t base = live_bytes.load();
+    peak_bytes.store(base);
+    const auto start = std::chrono::steady_clock::now();
+    b.run(w, threads);
+    const auto stop = std::chrono::steady_clock::now();
+    seconds.push_back(std::chrono::duration<double>(stop - start).count());
+    peak = std::max(peak, peak_bytes.load() - base);
+  }
+  std::sort(seconds.begin(), seconds.end());
+  return Measurement{.seconds = seconds[seconds.size() / 2],
+                     .peak_bytes = peak};
+}
+
+std::vector<std::string> split(const std::string& s) {
+  std::vector<std::string> parts;
+  std::size_t begin = 0;
+  while (begin <= s.size()) {
+    const std::size_t end = std::min(s.find(',', begin), s.size());
+    parts.push_back(s.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return parts;
+}
+
+Options parse(const int argc, char** argv) {
+  Options o;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if (flag == "--generators") {
+      o.generators = split(value);
+    } else if (flag == "--scale") {
+      o.scale = std::stoi(value);
+    } else if (flag == "--edge-factor") {
+      o.edge_factor = std::stoi(value);
+    } else if (flag == "--threads") {
+      for (const std::string& t : split(value)) {
+        o.threads.push_back(std::stoi(t));
+      }
+    } else if (flag == "--repeats") {
+      o.repeats = std::max(1, std::stoi(value));
+    } else if (flag == "--filter") {
+      o.filter = value;
+    } else if (flag == "--seed") {
+      o.seed = std::stoull(value);
+    } else {
+      std::cerr << "unknown option " << flag << '\n';
+      std::exit(1);
+    }
+  }
+  if (o.threads.empty()) {
+    for (int t = 1; t < hardware_threads(); t *= 2) {
+      o.threads.push_back(t);
+    }
+    o.threads.push_back(hardware_threads());
+  }
+  return o;
+}
+
+int main(int argc, char** argv) {
+  const Options o = parse(argc, argv);
+  // the Graph based SSSPs print the path they find.
+  std::cout.setstate(std::ios::badbit);
+
+  std::printf("%-10s %-38s %7s %9s %10s %10s %9s %8s %9s\n", "workload",
+              "algorithm", "threads", "V", "E", "ms", "MTEPS", "speedup",
+              "peak MB");
+  for (const std::string& generator : o.generators) {
+    Workload w = make_workload(generator, o);
+    for (const Benchmark& b : benchmarks()) {
+      if (b.name.find(o.filter) == std::string::npos ||
+          (!b.only_on.empty() && b.only_on != generator)) {
+        continue;
+      }
+      if (b.prepare) {
+        b.prepare(w);
+      }
+      const CsrGraph& input = input_of(w, b.input);
+      const std::vector<int> threads =
+          b.parallel ? o.threads : std::vector<int>{1};
+      double baseline = 0;
+      for (const int& t : threads) {
+        const Measurement m = measure(b, w, t, o.repeats);
+        if (baseline == 0) {
+          baseline = m.seconds;
+        }
+        std::printf("%-10s %-38s %7d %9d %10d %10.2f %9.2f %8.2f %9.2f\n",
+                    w.name.c_str(), b.name.c_str(), t, input.num_vertices(),
+                    input.num_edges(), m.seconds * 1e3,
+                    input.num_edges() / m.seconds / 1e6,
+                    baseline / m.seconds, m.peak_bytes / 1048576.0);
+        std::fflush(stdout);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,273 @@
+#ifndef BFS_HPP_
+#define BFS_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+#include "stats.hpp"
+
+// direction-optimizing parallel BFS, after Beamer et al.
+// this algo works as below, level by level:
+// - top-down: each frontier vertex scans its outgoing edges and claims the
+//   unvisited targets by an atomic test-and-set on the visited bitmap. cost:
+//   the outgoing edges of the frontier.
+// - bottom-up: each unvisited vertex scans its incoming edges until it finds
+//   a parent in the frontier bitmap. cost: the incoming edges of the
+//   unvisited vertices, but a vertex stops at its first parent.
+// top-down is cheap while the frontier is small. once the frontier's edges
+// outnumber the unexplored edges / ALPHA, most of them lead to visited
+// vertices anyway and bottom-up is cheaper. when the frontier shrinks below
+// V / BETA again, switch back.
+//
+// intuition: on low-diameter graphs, e.g. social networks, a few middle
+// levels hold most vertices. top-down checks nearly every edge there, while
+// bottom-up lets each unvisited vertex stop at the first of its many parents.
+//
+// the result is a ShortestPathTree with dist = #edges from src, the same as
+// DijkstraEngine on unit weights. where several parents are on the previous
+// level, which one is picked depends on the thread interleaving.
+class DirectionOptimizingBfs {
+ public:
+  // the switching thresholds suggested by Beamer et al.
+  static constexpr int ALPHA = 15;
+  static constexpr int BETA = 18;
+  // a step over fewer vertices is processed by the calling thread only, e.g.
+  // the many small levels of a road-like graph.
+  static constexpr std::size_t PARALLEL_FRONTIER = 1 << 10;
+
+  explicit DirectionOptimizingBfs(const CsrGraph& g,
+                                  const int num_threads = hardware_threads())
+      : DirectionOptimizingBfs(g, g.reversed(), num_threads) {}
+  /// @param rg g.reversed(), passed in if the caller already has it, or g
+  /// itself if g is undirected, i.e. holds both directions of each edge.
+  DirectionOptimizingBfs(const CsrGraph& g, const CsrGraph& rg,
+                         const int num_threads = hardware_threads())
+      : g{g},
+        rg{rg},
+        n{g.num_vertices()},
+        num_words{(static_cast<std::size_t>(n) + 63) / 64},
+        num_threads{std::max(1, num_threads)},
+        visited(std::make_unique<std::atomic<uint64_t>[]>(num_words)),
+        front(num_words),
+        next(num_words),
+        local(this->num_threads) {}
+
+  ShortestPathTree run(const int src) {
+    ShortestPathTree tree;
+    tree.src = src;
+    tree.dist.assign(n, MAX_DIST);
+    tree.parent.assign(n, -1);
+    for (std::size_t i = 0; i < num_words; ++i) {
+      visited[i].store(0, std::memory_order_relaxed);
+    }
+
+    GRAPH_STATS(thread_stats.assign(num_threads, AlgoStats{});)
+
+    visit(src);
+    tree.dist[src] = 0;
+    std::vector<int> queue{src};
+    // #edges out of the vertices not visited yet.
+    long long edges_to_check = g.num_edges();
+    // #edges out of the frontier.
+    long long scout = g.degree(src);
+    int level = 0;
+    while (!queue.empty()) {
+      if (scout > edges_to_check / ALPHA) {
+        GRAPH_STATS(PhaseTimer timer(tree.stats, "bottom_up");)
+        queue_to_bitmap(queue);
+        long long awake = static_cast<long long>(queue.size());
+        long long old_awake = 0;
+        do {
+          old_awake = awake;
+          GRAPH_STATS(tree.stats.add_frontier(level, awake);)
+          // the same accounting as top-down, so the next switch test sees
+          // the edges left unexplored.
+          edges_to_check -= scout;
+          awake = bottom_up_step(tree, level++, scout);
+          std::swap(front, next);
+        } while (awake > 0 && (awake >= old_awake || awake > n / BETA));
+        bitmap_to_queue(queue);
+      } else {
+        GRAPH_STATS(PhaseTimer timer(tree.stats, "top_down");
+                    tree.stats.add_frontier(level, queue.size());)
+        edges_to_check -= scout;
+        scout = top_down_step(tree, queue, level++);
+      }
+    }
+    GRAPH_STATS(for (const AlgoStats& s : thread_stats) { tree.stats += s; }
+                // each vertex reached is in exactly one frontier.
+                for (const uint64_t& size : tree.stats.frontier_sizes) {
+                  tree.stats.vertices_settled += size;
+                })
+    return tree;
+  }
+
+ private:
+  bool is_visited(const int v) const {
+    return visited[v >> 6].load(std::memory_order_relaxed) >> (v & 63) & 1;
+  }
+
+  // claim v. false if v was visited already.
+  bool visit(const int v) {
+    const uint64_t bit = uint64_t{1} << (v & 63);
+    return (visited[v >> 6].fetch_or(bit, std::memory_order_relaxed) & bit) ==
+           0;
+  }
+
+  /// @return #edges out of the next frontier.
+  long long top_down_step(ShortestPathTree& tree, std::vector<int>& queue,
+                          const int level) {
+    const std::span<const int> offsets = g.offsets();
+    const std::span<const int> targets = g.targets();
+    std::atomic<long long> scout{0};
+    step(queue.size(), queue.size(),
+         [&](std::size_t begin, std::size_t end, const int t) {
+           std::vector<int>& out = local[t];
+           long long local_scout = 0;
+           GRAPH_STATS(uint64_t scanned = 0;)
+           for (std::size_t k = begin; k < end; ++k) {
+             const int v = queue[k];
+             GRAPH_STATS(scanned += offsets[v + 1] - offsets[v];)
+             for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+               const int w = targets[i];
+               // test before test-and-set, since most targets are
+               // visited on dense levels.
+               if (!is_visited(w) && visit(w)) {
+                 tree.dist[w] = level + 1;
+                 tree.parent[w] = v;
+                 out.push_back(w);
+                 local_scout += g.degree(w);
+               }
+             }
+           }
+           scout.fetch_add(local_scout, std::memory_order_relaxed);
+           // counted locally, the per-thread stats share cache lines.
+           GRAPH_STATS(thread_stats[t].edges_scanned += scanned;)
+         });
+    gather(queue);
+    return scout.load(std::memory_order_relaxed);
+  }
+
+  // the frontier is in front, the next frontier goes to next.
+  // each thread owns whole words of the bitmaps, so only those it writes.
+  /// @param scout set to #edges out of the next frontier.
+  /// @return #vertices of the next frontier.
+  long long bottom_up_step(ShortestPathTree& tree, const int level,
+                           long long& scout) {
+    const std::span<const int> offsets = rg.offsets();
+    const std::span<const int> targets = rg.targets();
+    std::atomic<long long> awake{0};
+    std::atomic<long long> next_scout{0};
+    step(num_words, n,
+         [&](std::size_t begin, std::size_t end, [[maybe_unused]] const int t) {
+           long long local_awake = 0;
+           long long local_scout = 0;
+           GRAPH_STATS(uint64_t scanned = 0;)
+           for (std::size_t word = begin; word < end; ++word) {
+             uint64_t seen = visited[word].load(std::memory_order_relaxed);
+             uint64_t found = 0;
+             const int first = static_cast<int>(word * 64);
+             const int last = std::min(n, first + 64);
+             for (int v = first; v < last; ++v) {
+               if (seen >> (v & 63) & 1) {
+                 continue;
+               }
+               for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                 const int u = targets[i];
+                 GRAPH_STATS(++scanned;)
+                 if (front[u >> 6] >> (u & 63) & 1) {
+                   tree.dist[v] = level + 1;
+                   tree.parent[v] = u;
+                   found |= uint64_t{1} << (v & 63);
+                   ++local_awake;
+                   local_scout += g.degree(v);
+                   break;
+                 }
+               }
+             }
+             seen |= found;
+             visited[word].store(seen, std::memory_order_relaxed);
+             next[word] = found;
+           }
+           awake.fetch_add(local_awake, std::memory_order_relaxed);
+           next_scout.fetch_add(local_scout, std::memory_order_relaxed);
+           GRAPH_STATS(thread_stats[t].edges_scanned += scanned;)
+         });
+    scout = next_scout.load(std::memory_order_relaxed);
+    return awake.load(std::memory_order_relaxed);
+  }
+
+  void queue_to_bitmap(const std::vector<int>& queue) {
+    std::fill(front.begin(), front.end(), 0);
+    for (const int& v : queue) {
+      front[v >> 6] |= uint64_t{1} << (v & 63);
+    }
+  }
+
+  void bitmap_to_queue(std::vector<int>& queue) {
+    step(num_words, n,
+         [&](std::size_t begin, std::size_t end, const int t) {
+           for (std::size_t word = begin; word < end; ++word) {
+             for (uint64_t bits = front[word]; bits != 0; bits &= bits - 1) {
+               local[t].push_back(static_cast<int>(word * 64) +
+                                  __builtin_ctzll(bits));
+             }
+           }
+         });
+    gather(queue);
+  }
+
+  // fn(begin, end, t) over [0, size) by parallel_for, or on the calling
+  // thread as the thread 0 if the step touches fewer than PARALLEL_FRONTIER
+  // vertices, where starting the threads would cost more than the step.
+  void step(const std::size_t size, const std::size_t vertices,
+            const std::function<void(std::size_t, std::size_t, int)>& fn) {
+    if (vertices >= PARALLEL_FRONTIER) {
+      parallel_for(size, num_threads, fn);
+    } else if (size > 0) {
+      fn(0, size, 0);
+    }
+  }
+
+  // concatenate the per-thread buffers into queue, and clear them.
+  // a few copies, so on the calling thread.
+  void gather(std::vector<int>& queue) {
+    queue.clear();
+    for (std::vector<int>& out : local) {
+      queue.insert(queue.end(), out.begin(), out.end());
+      out.clear();
+    }
+  }
+
+  // copies are cheap since they share the storage of the graphs.
+  const CsrGraph g;
+  const CsrGraph rg;
+  const int n;
+  const std::size_t num_words;
+  const int num_threads;
+  std::unique_ptr<std::atomic<uint64_t>[]> visited;
+  // frontier bitmaps of the bottom-up steps.
+  std::vector<uint64_t> front;
+  std::vector<uint64_t> next;
+  // per-thread buffers of the next frontier of the top-down steps.
+  std::vector<std::vector<int>> local;
+  // per-thread counters of the current run, summed into the tree at the end.
+  GRAPH_STATS(std::vector<AlgoStats> thread_stats;)
+};
+
+// one-shot wrapper.
+ShortestPathTree parallel_bfs(const CsrGraph& g, const int src,
+                              const int num_threads = hardware_threads()) {
+  return DirectionOptimizingBfs(g, num_threads).run(src);
+}
+
+#endif  // BFS_HPP_
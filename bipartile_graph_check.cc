@@ -1,7 +1,16 @@
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
 
+#include "connected_components.hpp"
+#include "csr_graph.hpp"
+#include "dfs.hpp"
 #include "graph.hpp"
+#include "parallel.hpp"
 
 // algorithms for checking if a undirected graph is a bipartile graph.
 // a bipartile graph is such a graph: vertices can be grouped
@@ -14,35 +23,151 @@
 // vertex. If the outgoing vertex is visited and has the same color with
 // the ingoing vertex, then this violates the bipartile graph property, i.e.
 // the two vertices in each edge belong to different set.
-bool dfs(const Graph& g, const int v, std::unordered_map<int, int>& color,
-         const int my_color, std::unordered_set<int>& visited) {
-  visited.insert(v);
-  color[v] = my_color;
-
-  for (const Edge& e : g.edges(v)) {
-    if (visited.count(e.w) == 0) {
-      // assign opposite color.
-      if (!dfs(g, e.w, color, -my_color, visited)) {
-        return false;
+// the colors are kept in a flat array over the dense vertex indices, and the
+// visited set is the DFS engine's.
+template <typename G>
+bool alter_two_color_bipartile_graph_check(const G& g) {
+  const CsrGraph csr = as_csr_graph(g);
+  DfsEngine engine(csr);
+  struct Visitor : DfsVisitor {
+    void discover(const int v) {
+      // a root starts with color 1, a child gets the opposite color.
+      const int p = engine.parent(v);
+      color[v] = p == -1 ? 1 : -color[p];
+    }
+    // a non-tree edge to a vertex of the same color.
+    void back_edge(const int v, const int w) {
+      odd = odd || color[v] == color[w];
+    }
+    void forward_or_cross_edge(const int v, const int w) { back_edge(v, w); }
+    bool stop() const { return odd; }
+    const DfsEngine& engine;
+    std::vector<signed char> color;
+    bool odd;
+  } visitor{{}, engine, std::vector<signed char>(csr.num_vertices(), 0),
+            false};
+  return engine.run_all(visitor);
+}
+
+// the result of parallel_bipartite_check.
+struct BipartiteResult {
+  bool bipartite{true};
+  // key: dense vertex index, value: its side of the partition, 0 or 1.
+  // empty if not bipartite.
+  std::vector<int8_t> side;
+  // an odd cycle v0 - v1 - ... - vk - v0 of dense vertex indices, listed
+  // without repeating v0, if not bipartite.
+  std::vector<int> odd_cycle;
+};
+
+// parallel alternating two coloring by a level-synchronous BFS.
+// this algo works as below:
+// (1) find the connected components by the parallel union-find, and seed the
+//     BFS with one vertex per component. so all components are colored at
+//     once, and even the many small components of a matching graph keep the
+//     threads busy.
+// (2) expand each frontier in parallel. a vertex claims an uncolored neighbor
+//     by a CAS from 0 to the opposite color, the color of the next level.
+// (3) a BFS edge joins two adjacent levels, or two vertices of the same
+//     level. the latter is an edge between two vertices of the same color,
+//     i.e. the graph is not bipartite. it's seen when either end expands.
+// the odd cycle witness is the edge v - w of such a level together with the
+// BFS tree paths from v and w up to their lowest common ancestor. both paths
+// have the same length, so the cycle is odd.
+// g is undirected, i.e. holds both directions of each edge.
+BipartiteResult parallel_bipartite_check(
+    const CsrGraph& g, const int num_threads = hardware_threads()) {
+  // a frontier below this size is processed by the calling thread only.
+  constexpr std::size_t PARALLEL_FRONTIER = 1 << 10;
+  constexpr uint64_t NO_CONFLICT = ~uint64_t{0};
+
+  const int n = g.num_vertices();
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  // 0: uncolored, 1 or -1 otherwise.
+  const auto color = std::make_unique<std::atomic<int8_t>[]>(n);
+  // the BFS tree, written by the thread claiming each vertex only.
+  std::vector<int> parent(n, -1);
+
+  std::vector<int> frontier;
+  {
+    const std::vector<int> cc = parallel_uf_connected_components(g,
+                                                                 num_threads);
+    for (int v = 0; v < n; ++v) {
+      const bool root = cc[v] == v;
+      color[v].store(root ? 1 : 0, std::memory_order_relaxed);
+      if (root) {
+        frontier.push_back(v);
       }
-    } else if (color[v] == color[e.w]) {
-      return false;
     }
   }
 
-  return true;
-}
-
-bool alter_two_color_bipartile_graph_check(const Graph& g) {
-  std::unordered_set<int> visited;
-  std::unordered_map<int, int> color;
-  const int my_color = 1;
-  for (const int& v : g.all_vertices()) {
-    if (visited.count(v) == 0) {
-      if (!dfs(g, v, color, my_color, visited)) {
-        return false;
+  // the first conflicting edge found, packed as v << 32 | w.
+  std::atomic<uint64_t> conflict{NO_CONFLICT};
+  std::vector<std::vector<int>> local(std::max(1, num_threads));
+  const auto expand = [&](const int v, std::vector<int>& next) {
+    const int8_t c = color[v].load(std::memory_order_relaxed);
+    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+      const int w = targets[i];
+      int8_t expected = 0;
+      if (color[w].compare_exchange_strong(expected, -c,
+                                           std::memory_order_relaxed)) {
+        parent[w] = v;
+        next.push_back(w);
+      } else if (expected == c) {
+        uint64_t none = NO_CONFLICT;
+        conflict.compare_exchange_strong(
+            none, static_cast<uint64_t>(v) << 32 | static_cast<uint32_t>(w),
+            std::memory_order_relaxed);
+        return;
       }
     }
+  };
+  while (!frontier.empty() &&
+         conflict.load(std::memory_order_relaxed) == NO_CONFLICT) {
+    if (frontier.size() < PARALLEL_FRONTIER) {
+      for (const int& v : frontier) {
+        expand(v, local[0]);
+      }
+    } else {
+      parallel_for(frontier.size(), num_threads,
+                   [&](std::size_t begin, std::size_t end, const int t) {
+                     for (std::size_t i = begin; i < end; ++i) {
+                       expand(frontier[i], local[t]);
+                     }
+                   });
+    }
+    frontier.clear();
+    for (std::vector<int>& l : local) {
+      frontier.insert(frontier.end(), l.begin(), l.end());
+      l.clear();
+    }
   }
-  return true;
-}
\ No newline at end of file
+
+  BipartiteResult result;
+  const uint64_t edge = conflict.load(std::memory_order_relaxed);
+  if (edge == NO_CONFLICT) {
+    result.side.resize(n);
+    for (int v = 0; v < n; ++v) {
+      result.side[v] = color[v].load(std::memory_order_relaxed) == 1 ? 0 : 1;
+    }
+    return result;
+  }
+
+  // v and w are on the same level, so walk up from both in lockstep.
+  result.bipartite = false;
+  int v = static_cast<int>(edge >> 32);
+  int w = static_cast<int>(static_cast<uint32_t>(edge));
+  std::vector<int> down;
+  while (v != w) {
+    result.odd_cycle.push_back(v);
+    down.push_back(w);
+    v = parent[v];
+    w = parent[w];
+  }
+  // lca -> ... -> v, then w -> ... back up to the child of lca.
+  result.odd_cycle.push_back(v);
+  std::reverse(result.odd_cycle.begin(), result.odd_cycle.end());
+  result.odd_cycle.insert(result.odd_cycle.end(), down.begin(), down.end());
+  return result;
+}
@@ -1,54 +1,59 @@
 #ifndef CONNECTED_COMPONENTS_HPP_
 #define CONNECTED_COMPONENTS_HPP_
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
+#include "csr_graph.hpp"
+#include "dfs.hpp"
 #include "graph.hpp"
+#include "parallel.hpp"
 #include "union_find.hpp"
+#include "workspace.hpp"
 
 /// algorithms to find connected components of a undirected graph.
 
-// dfs.
-void dfs(const Graph& g, const int v, const int cc_id,
-         std::unordered_map<int, std::list<int>>& cc,
-         std::unordered_set<int>& visited) {
-  visited.insert(v);
-  cc[cc_id].push_back(v);
-
-  for (const Edge& e : g.edges(v)) {
-    if (visited.count(e.w) == 0) {
-      dfs(g, e.w, cc_id, cc, visited);
-    }
-  }
-}
+// the ones on a Graph allocate their scratch, e.g. the CSR snapshot of the
+// graph and the union-find maps, from a Workspace, by default the one of the
+// calling thread. only the returned components are on the heap.
 
+// dfs.
+// each DFS run from an unvisited vertex visits exactly one cc.
+template <typename G>
 std::unordered_map<int, std::list<int>> dfs_connected_components(
-    const Graph& g) {
-  int cc_id = 0;                    // the id of the next cc.
-  std::unordered_set<int> visited;  // contains visited vertices.
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const CsrGraph csr = as_csr_graph(g, ws.resource());
   // key: cc_id, value: vertices in this cc.
   std::unordered_map<int, std::list<int>> cc;
-  for (const int& v : g.all_vertices()) {
-    if (visited.count(v) == 0) {
-      dfs(g, v, cc_id, cc, visited);
-      ++cc_id;
-    }
-  }
+
+  struct Visitor : DfsVisitor {
+    void discover(const int v) { members->push_back(vertex_of<G>(csr, v)); }
+    const CsrGraph& csr;
+    // the vertices of the cc being visited.
+    std::list<int>* members;
+  } visitor{{}, csr, nullptr};
+
+  int cc_id = 0;  // the id of the next cc.
+  DfsEngine engine(csr, ws.resource());
+  engine.run_all(visitor,
+                 [&](int) { visitor.members = &cc[cc_id++]; });
   return cc;
 }
 
 // union-find.
+template <typename G>
 std::unordered_map<int, std::list<int>> uf_connected_components(
-    const Graph& g) {
-  UF uf;
-  for (const int& v : g.all_vertices()) {
-    uf.add_vertex(v);
-  }
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  auto uf = make_uf(g, ws.resource());
 
-  // edges provide the connection.
-  for (const Edge& e : g.all_edges()) {
-    uf.union_vertices(e.v, e.w);
+  // edges provide the connection. they are read in place rather than copied
+  // by all_edges().
+  for (const int& v : g.all_vertices()) {
+    for (const Edge& e : g.edges(v)) {
+      uf.union_vertices(e.v, e.w);
+    }
   }
 
   // key: cc_id, value: vertices in this cc.
@@ -64,4 +69,41 @@ std::unordered_map<int, std::list<int>> uf_connected_components(
   return cc;
 }
 
+// parallel union-find.
+// the edge slots of the CSR graph are split into equal chunks and each thread
+// unions the endpoints of the edges in its chunk into a shared lock-free
+// union-find. so the work is balanced by #edges rather than #vertices.
+/// @return key: vertex, value: cc id. note, cc ids are chosen from the
+/// vertices, i.e. the root of each cc.
+std::vector<int> parallel_uf_connected_components(
+    const CsrGraph& g, const int num_threads = hardware_threads()) {
+  ConcurrentUF uf(g.num_vertices());
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+
+  parallel_for(g.num_edges(), num_threads,
+               [&](std::size_t begin, std::size_t end, int) {
+                 // the source vertex of the first edge slot in this chunk.
+                 int v = static_cast<int>(
+                     std::upper_bound(offsets.begin(), offsets.end(),
+                                      static_cast<int>(begin)) -
+                     offsets.begin() - 1);
+                 for (std::size_t i = begin; i < end; ++i) {
+                   while (static_cast<std::size_t>(offsets[v + 1]) <= i) {
+                     ++v;
+                   }
+                   uf.union_vertices(v, targets[i]);
+                 }
+               });
+
+  std::vector<int> cc(g.num_vertices());
+  parallel_for(g.num_vertices(), num_threads,
+               [&](std::size_t begin, std::size_t end, int) {
+                 for (std::size_t v = begin; v < end; ++v) {
+                   cc[v] = uf.find(v);
+                 }
+               });
+  return cc;
+}
+
 #endif  // CONNECTED_COMPONENTS_HPP_
\ No newline at end of file
@@ -0,0 +1,569 @@
+#ifndef CONTRACTION_HIERARCHIES_HPP_
+#define CONTRACTION_HIERARCHIES_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "dijkstra_engine.hpp"
+#include "graph_file.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+
+// contraction hierarchies (CH) for source-sink shortest path queries on large
+// road-like graphs.
+// this algo works as below:
+// (1) preprocessing: contract the vertices one by one in some order. to
+//     contract a vertex v is to remove it from the graph while preserving all
+//     shortest paths among the remaining vertices, i.e. for each path
+//     u -> v -> w, add a shortcut edge u -> w with the same weight unless a
+//     witness path u -> ... -> w not via v is no longer.
+//     the rank of a vertex is its position in the contraction order.
+// (2) the hierarchy is the original graph plus all shortcuts. for any pair of
+//     vertices, some shortest path goes up in rank first and then down.
+// (3) query: a bidirectional Dijkstra where the forward search from src only
+//     follows upward edges and the backward search from dst only follows
+//     downward edges reversed. both searches are tiny since only a few
+//     vertices have high rank.
+// (4) the shortcuts on the found path are unpacked recursively by the
+//     contracted vertex each one bypasses.
+//
+// node ordering: the priority of a vertex is its edge difference, i.e.
+// #shortcuts its contraction adds minus #edges it removes, plus #its
+// contracted neighbors, which spreads the contraction evenly over the graph.
+// the contraction runs in rounds: each round contracts all vertices whose
+// priority is lower than that of all their remaining neighbors. such vertices
+// are independent, so their witness searches run in parallel. the witness
+// searches avoid all vertices of the round to stay correct.
+
+class ContractionHierarchy {
+ public:
+  ContractionHierarchy() = default;
+
+  // preprocess the graph.
+  /// @param witness_settle_limit #vertices a witness search settles at most.
+  /// a lower limit preprocesses faster but may add unnecessary shortcuts.
+  static ContractionHierarchy build(const CsrGraph& g,
+                                    const int num_threads = hardware_threads(),
+                                    const int witness_settle_limit = 500) {
+    Contractor contractor(g, num_threads, witness_settle_limit);
+    return contractor.run();
+  }
+
+  int num_vertices() const { return static_cast<int>(rank_.size()); }
+  // position of the vertex v in the contraction order.
+  int rank(const int v) const { return rank_[v]; }
+  // #edges of the hierarchy, i.e. original edges plus shortcuts.
+  int num_edges() const { return up.num_edges() + down.num_edges(); }
+
+  // save the hierarchy as three files:
+  // - path + ".up": upward edges, a binary graph file (see graph_file.hpp).
+  // - path + ".down": downward edges reversed, a binary graph file.
+  // - path: the ranks and the middle vertices of the shortcuts.
+  /// @return false if any file cannot be written.
+  bool save(const std::string& path) const {
+    if (!save_csr_graph(up, path + ".up") ||
+        !save_csr_graph(down, path + ".down")) {
+      return false;
+    }
+    const uint64_t header[4] = {VERSION, static_cast<uint64_t>(num_vertices()),
+                                up_middle.size(), down_middle.size()};
+    const std::size_t size = sizeof(MAGIC) + sizeof(header) +
+                             (rank_.size() + up_middle.size() +
+                              down_middle.size()) *
+                                 sizeof(int32_t);
+    const std::shared_ptr<MappedFile> file = MappedFile::create(path, size);
+    if (file == nullptr) {
+      return false;
+    }
+    char* p = file->data();
+    const auto put = [&](const void* data, const std::size_t n) {
+      std::memcpy(p, data, n);
+      p += n;
+    };
+    put(MAGIC, sizeof(MAGIC));
+    put(header, sizeof(header));
+    put(rank_.data(), rank_.size() * sizeof(int32_t));
+    put(up_middle.data(), up_middle.size() * sizeof(int32_t));
+    put(down_middle.data(), down_middle.size() * sizeof(int32_t));
+    return msync(file->data(), file->size(), MS_SYNC) == 0;
+  }
+
+  // load a hierarchy saved by save(). the edge files are memory-mapped.
+  /// @return false if any file cannot be read or is malformed.
+  static bool load(const std::string& path, ContractionHierarchy& ch) {
+    if (!map_csr_graph(path + ".up", ch.up) ||
+        !map_csr_graph(path + ".down", ch.down)) {
+      return false;
+    }
+    const std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    uint64_t header[4];
+    if (file == nullptr || file->size() < sizeof(MAGIC) + sizeof(header) ||
+        std::memcmp(file->data(), MAGIC, sizeof(MAGIC)) != 0) {
+      return false;
+    }
+    std::memcpy(header, file->data() + sizeof(MAGIC), sizeof(header));
+    const uint64_t n = header[1];
+    if (header[0] != VERSION ||
+        n != static_cast<uint64_t>(ch.up.num_vertices()) ||
+        header[2] != static_cast<uint64_t>(ch.up.num_edges()) ||
+        header[3] != static_cast<uint64_t>(ch.down.num_edges()) ||
+        file->size() < sizeof(MAGIC) + sizeof(header) +
+                           (n + header[2] + header[3]) * sizeof(int32_t)) {
+      return false;
+    }
+    const int* p = reinterpret_cast<const int*>(file->data() + sizeof(MAGIC) +
+                                                sizeof(header));
+    ch.rank_.assign(p, p + n);
+    p += n;
+    ch.up_middle.assign(p, p + header[2]);
+    p += header[2];
+    ch.down_middle.assign(p, p + header[3]);
+    return true;
+  }
+
+ private:
+  friend class ChQuery;
+
+  static constexpr char MAGIC[8] = {'C', 'H', 'I', 'E', 'R', 'A', 'R', 'C'};
+  static constexpr uint64_t VERSION = 1;
+
+  // edge of the graph being contracted.
+  struct Arc {
+    int to;
+    int weight;
+    // the contracted vertex a shortcut bypasses, or -1 for an original edge.
+    int middle;
+  };
+
+  // shortcut found by a witness search, to be added after the round.
+  struct Shortcut {
+    int from;
+    int to;
+    int weight;
+    int middle;
+  };
+
+  // state of the preprocessing.
+  class Contractor {
+   public:
+    // per-thread witness search state.
+    struct Witness {
+      explicit Witness(const int n) : ws(n), target(n, 0) {}
+
+      DijkstraWorkspace ws;
+      // target[w] == token iff w is an out-neighbor of the vertex whose
+      // shortcuts are being searched.
+      std::vector<uint32_t> target;
+      uint32_t token{0};
+    };
+
+    Contractor(const CsrGraph& g, const int num_threads,
+               const int witness_settle_limit)
+        : g{g},
+          n{g.num_vertices()},
+          num_threads{std::max(1, num_threads)},
+          settle_limit{witness_settle_limit},
+          out(n),
+          in(n),
+          rank(n, -1),
+          in_round(n, 0),
+          deleted_neighbors(n, 0),
+          priority(n, 0) {
+      for (int v = 0; v < n; ++v) {
+        for (const Edge& e : g.edges(v)) {
+          // self loops never lie on a shortest path.
+          if (e.v != e.w) {
+            add_arc(e.v, Arc{.to = e.w, .weight = e.weight, .middle = -1});
+          }
+        }
+      }
+      for (int t = 0; t < this->num_threads; ++t) {
+        witness.emplace_back(n);
+      }
+    }
+
+    ContractionHierarchy run() {
+      std::vector<int> remaining(n);
+      for (int v = 0; v < n; ++v) {
+        remaining[v] = v;
+      }
+      update_priorities(remaining);
+
+      // key: vertex, value: its upward arcs / reversed downward arcs, i.e.
+      // the arcs to its neighbors remaining when it's contracted.
+      std::vector<std::vector<Arc>> up_arcs(n);
+      std::vector<std::vector<Arc>> down_arcs(n);
+
+      int next_rank = 0;
+      while (!remaining.empty()) {
+        const std::vector<int> round = independent_set(remaining);
+        for (const int& v : round) {
+          in_round[v] = 1;
+        }
+
+        // witness searches of the round, in parallel.
+        std::vector<std::vector<Shortcut>> shortcuts(round.size());
+        parallel_for(round.size(), num_threads,
+                     [&](std::size_t begin, std::size_t end, int t) {
+                       for (std::size_t i = begin; i < end; ++i) {
+                         find_shortcuts(round[i], witness[t], &shortcuts[i]);
+                       }
+                     });
+
+        // contract the round sequentially, since neighbors are shared.
+        std::vector<int> touched;
+        for (std::size_t i = 0; i < round.size(); ++i) {
+          const int v = round[i];
+          rank[v] = next_rank++;
+          up_arcs[v] = out[v];
+          down_arcs[v] = in[v];
+          for (const Arc& a : out[v]) {
+            erase_arc(in[a.to], v);
+            ++deleted_neighbors[a.to];
+            touched.push_back(a.to);
+          }
+          for (const Arc& a : in[v]) {
+            erase_arc(out[a.to], v);
+            ++deleted_neighbors[a.to];
+            touched.push_back(a.to);
+          }
+          out[v].clear();
+          in[v].clear();
+          for (const Shortcut& s : shortcuts[i]) {
+            add_arc(s.from,
+                    Arc{.to = s.to, .weight = s.weight, .middle = s.middle});
+          }
+        }
+        for (const int& v : round) {
+          in_round[v] = 0;
+        }
+
+        remaining.erase(
+            std::remove_if(remaining.begin(), remaining.end(),
+                           [&](const int v) { return rank[v] >= 0; }),
+            remaining.end());
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()),
+                      touched.end());
+        update_priorities(touched);
+      }
+
+      ContractionHierarchy ch;
+      ch.rank_ = rank;
+      ch.up = freeze(up_arcs, ch.up_middle);
+      ch.down = freeze(down_arcs, ch.down_middle);
+      return ch;
+    }
+
+   private:
+    // add the arc, or lower the weight of the existing arc to the same vertex.
+    void add_arc(const int from, const Arc& a) {
+      const auto upsert = [](std::vector<Arc>& arcs, const Arc& a) {
+        for (Arc& b : arcs) {
+          if (b.to == a.to) {
+            if (a.weight < b.weight) {
+              b = a;
+            }
+            return;
+          }
+        }
+        arcs.push_back(a);
+      };
+      upsert(out[from], a);
+      upsert(in[a.to], Arc{.to = from, .weight = a.weight, .middle = a.middle});
+    }
+
+    static void erase_arc(std::vector<Arc>& arcs, const int to) {
+      for (std::size_t i = 0; i < arcs.size(); ++i) {
+        if (arcs[i].to == to) {
+          arcs[i] = arcs.back();
+          arcs.pop_back();
+          return;
+        }
+      }
+    }
+
+    // the vertices whose (priority, id) is lower than that of all their
+    // remaining neighbors.
+    std::vector<int> independent_set(const std::vector<int>& remaining) {
+      std::vector<char> picked(remaining.size(), 0);
+      const auto lower = [&](const int v, const int w) {
+        return priority[v] != priority[w] ? priority[v] < priority[w] : v < w;
+      };
+      parallel_for(remaining.size(), num_threads,
+                   [&](std::size_t begin, std::size_t end, int) {
+                     for (std::size_t i = begin; i < end; ++i) {
+                       const int v = remaining[i];
+                       bool min = true;
+                       for (const Arc& a : out[v]) {
+                         min = min && lower(v, a.to);
+                       }
+                       for (const Arc& a : in[v]) {
+                         min = min && lower(v, a.to);
+                       }
+                       picked[i] = min;
+                     }
+                   });
+      std::vector<int> round;
+      for (std::size_t i = 0; i < remaining.size(); ++i) {
+        if (picked[i]) {
+          round.push_back(remaining[i]);
+        }
+      }
+      return round;
+    }
+
+    // simulate the contraction of each vertex to update its priority.
+    void update_priorities(const std::vector<int>& vertices) {
+      parallel_for(vertices.size(), num_threads,
+                   [&](std::size_t begin, std::size_t end, int t) {
+                     for (std::size_t i = begin; i < end; ++i) {
+                       const int v = vertices[i];
+                       const int shortcuts = find_shortcuts(v, witness[t]);
+                       const int removed = static_cast<int>(out[v].size() +
+                                                            in[v].size());
+                       priority[v] = shortcuts - removed + deleted_neighbors[v];
+                     }
+                   });
+    }
+
+    // find the shortcuts needed to contract the vertex v.
+    // for each in-neighbor u, a limited Dijkstra from u not via v or any other
+    // vertex of the round looks for a witness to each out-neighbor w.
+    /// @param shortcuts if not null, the shortcuts are appended to it.
+    /// otherwise, it's a simulation for the priority.
+    /// @return #shortcuts.
+    int find_shortcuts(const int v, Witness& witness,
+                       std::vector<Shortcut>* shortcuts = nullptr) {
+      // the simulation for the priority only needs an estimate, so it uses a
+      // much smaller limit. too few witnesses only overestimate the priority.
+      const int limit =
+          shortcuts != nullptr ? settle_limit : std::max(1, settle_limit / 50);
+      DijkstraWorkspace& ws = witness.ws;
+      if (++witness.token == 0) {
+        std::fill(witness.target.begin(), witness.target.end(), 0);
+        witness.token = 1;
+      }
+      int max_out = 0;
+      for (const Arc& a : out[v]) {
+        max_out = std::max(max_out, a.weight);
+        witness.target[a.to] = witness.token;
+      }
+
+      int cnt = 0;
+      for (const Arc& ua : in[v]) {
+        const int u = ua.to;
+        const int bound = ua.weight + max_out;
+        // #out-neighbors not settled yet. the search stops once all are.
+        int left = static_cast<int>(out[v].size()) -
+                   (witness.target[u] == witness.token ? 1 : 0);
+
+        ws.reset();
+        ws.set(u, 0, -1);
+        ws.heap.push_or_decrease(u, 0);
+        for (int settled = 0; !ws.heap.empty() && settled < limit &&
+                              left > 0;
+             ++settled) {
+          if (ws.heap.top_key() > bound) {
+            break;
+          }
+          const int x = ws.heap.pop();
+          ws.settle(x);
+          if (x != u && witness.target[x] == witness.token) {
+            --left;
+          }
+          for (const Arc& a : out[x]) {
+            if (a.to == v || in_round[a.to] || ws.settled(a.to)) {
+              continue;
+            }
+            const int d = ws.dist(x) + a.weight;
+            if (d < ws.dist(a.to)) {
+              ws.set(a.to, d, x);
+              ws.heap.push_or_decrease(a.to, d);
+            }
+          }
+        }
+
+        for (const Arc& wa : out[v]) {
+          const int w = wa.to;
+          const int d = ua.weight + wa.weight;
+          if (w == u || ws.dist(w) <= d) {
+            continue;
+          }
+          ++cnt;
+          if (shortcuts != nullptr) {
+            shortcuts->push_back(
+                Shortcut{.from = u, .to = w, .weight = d, .middle = v});
+          }
+        }
+      }
+      return cnt;
+    }
+
+    // build the CSR graph of the hierarchy edges, keeping g's vertex ids so
+    // that the dense indices match.
+    /// @param middle the middle vertex of each CSR edge slot.
+    CsrGraph freeze(const std::vector<std::vector<Arc>>& arcs,
+                    std::vector<int>& middle) const {
+      std::vector<Edge> edges;
+      std::vector<int> vertices(n);
+      for (int v = 0; v < n; ++v) {
+        vertices[v] = g.id(v);
+        for (const Arc& a : arcs[v]) {
+          edges.push_back(
+              Edge{.v = g.id(v), .w = g.id(a.to), .weight = a.weight});
+        }
+      }
+      // CsrGraph keeps the edges of a vertex in the input order, so the
+      // middles follow the same order.
+      middle.clear();
+      for (int v = 0; v < n; ++v) {
+        for (const Arc& a : arcs[v]) {
+          middle.push_back(a.middle);
+        }
+      }
+      return CsrGraph(edges, vertices);
+    }
+
+    const CsrGraph& g;
+    const int n;
+    const int num_threads;
+    const int settle_limit;
+    // key: vertex, value: arcs to / from the remaining neighbors.
+    std::vector<std::vector<Arc>> out;
+    std::vector<std::vector<Arc>> in;
+    // key: vertex, value: its rank, or -1 if not contracted yet.
+    std::vector<int> rank;
+    // key: vertex, value: 1 if it's contracted in the current round.
+    std::vector<char> in_round;
+    // key: vertex, value: #its contracted neighbors.
+    std::vector<int> deleted_neighbors;
+    // key: vertex, value: its contraction priority, lower first.
+    std::vector<int> priority;
+    // per-thread witness search state.
+    std::vector<Witness> witness;
+  };
+
+  std::vector<int> rank_;
+  // upward edges v -> w with rank(v) < rank(w).
+  CsrGraph up;
+  // downward edges w -> v with rank(w) > rank(v), stored reversed as v -> w,
+  // so that the backward search goes upward too.
+  CsrGraph down;
+  // the middle vertex of each edge slot of up / down, or -1 for an original
+  // edge.
+  std::vector<int> up_middle;
+  std::vector<int> down_middle;
+};
+
+// query engine on a contraction hierarchy, which must outlive it.
+// reusable across queries, one per thread.
+class ChQuery {
+ public:
+  explicit ChQuery(const ContractionHierarchy& ch)
+      : ch{ch}, fwd(ch.num_vertices()), bwd(ch.num_vertices()) {}
+
+  ShortestPath shortest_path(const int src, const int dst) {
+    fwd.reset();
+    bwd.reset();
+    fwd.set(src, 0, -1);
+    fwd.heap.push_or_decrease(src, 0);
+    bwd.set(dst, 0, -1);
+    bwd.heap.push_or_decrease(dst, 0);
+
+    int mu = MAX_DIST;
+    int meet = -1;
+    const auto key = [](int, const int d) { return d; };
+    const auto no_scan = [](int, int) {};
+    // unlike a plain bidirectional Dijkstra, a side can only stop once its own
+    // lowest key reaches mu, since the up-down path may be found late.
+    while (true) {
+      const bool fwd_open = !fwd.heap.empty() && fwd.heap.top_key() < mu;
+      const bool bwd_open = !bwd.heap.empty() && bwd.heap.top_key() < mu;
+      if (!fwd_open && !bwd_open) {
+        break;
+      }
+      const bool forward =
+          fwd_open && (!bwd_open || fwd.heap.size() <= bwd.heap.size());
+      DijkstraWorkspace& self = forward ? fwd : bwd;
+      const DijkstraWorkspace& other = forward ? bwd : fwd;
+      const int v =
+          dijkstra_settle_next(forward ? ch.up : ch.down, self, key, no_scan);
+      const int rest = other.dist(v);
+      if (rest != MAX_DIST && self.dist(v) + rest < mu) {
+        mu = self.dist(v) + rest;
+        meet = v;
+      }
+    }
+    if (meet == -1) {
+      return {};
+    }
+
+    // the up-down path, possibly with shortcuts.
+    std::vector<int> packed;
+    for (int x = meet; x != -1; x = fwd.parent(x)) {
+      packed.push_back(x);
+    }
+    std::reverse(packed.begin(), packed.end());
+    for (int x = bwd.parent(meet); x != -1; x = bwd.parent(x)) {
+      packed.push_back(x);
+    }
+
+    ShortestPath sp{.found = true, .dist = mu, .path = {packed.front()}};
+    for (std::size_t i = 0; i + 1 < packed.size(); ++i) {
+      unpack(packed[i], packed[i + 1], sp.path);
+    }
+    return sp;
+  }
+
+ private:
+  // the middle vertex of the hierarchy edge v -> w, -1 for an original edge.
+  int middle(const int v, const int w) const {
+    // the edge is stored at its lower ranked endpoint.
+    const bool upward = ch.rank(v) < ch.rank(w);
+    const CsrGraph& h = upward ? ch.up : ch.down;
+    const std::vector<int>& middles = upward ? ch.up_middle : ch.down_middle;
+    const int from = upward ? v : w;
+    const int to = upward ? w : v;
+    const std::span<const int> offsets = h.offsets();
+    const std::span<const int> targets = h.targets();
+    for (int i = offsets[from]; i < offsets[from + 1]; ++i) {
+      if (targets[i] == to) {
+        return middles[i];
+      }
+    }
+    return -1;
+  }
+
+  // append the original path of the hierarchy edge v -> w to path, except v.
+  // iterative, so that deeply nested shortcuts won't overflow the stack.
+  void unpack(const int v, const int w, std::vector<int>& path) const {
+    // edges still to unpack, the top one is the next on the path.
+    std::vector<std::pair<int, int>> stack = {{v, w}};
+    while (!stack.empty()) {
+      const auto [a, b] = stack.back();
+      stack.pop_back();
+      const int m = middle(a, b);
+      if (m == -1) {
+        path.push_back(b);
+      } else {
+        stack.emplace_back(m, b);
+        stack.emplace_back(a, m);
+      }
+    }
+  }
+
+  const ContractionHierarchy& ch;
+  // upward search from src.
+  DijkstraWorkspace fwd;
+  // upward search from dst on the reversed downward edges.
+  DijkstraWorkspace bwd;
+};
+
+#endif  // CONTRACTION_HIERARCHIES_HPP_
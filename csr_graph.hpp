@@ -0,0 +1,417 @@
+#ifndef CSR_GRAPH_HPP_
+#define CSR_GRAPH_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "graph.hpp"
+
+// immutable directed weighted graph represented in the compressed sparse row
+// (CSR) format.
+// vertices are renumbered to dense indices 0..V-1 following the ascending
+// order of their original ids. the outgoing edges of the vertex v are stored
+// contiguously in targets[offsets[v]..offsets[v + 1]) along with their weights
+// in weights[offsets[v]..offsets[v + 1]).
+// compared to the adjacency list in Graph, iterating the neighbors of a vertex
+// is a linear scan over two flat arrays instead of a pointer chase over list
+// nodes, and any per-vertex state can be kept in a flat vector indexed by the
+// dense vertex index instead of an unordered_map.
+//
+// CsrGraph exposes the same neighbor-range interface as Graph and hence all
+// algorithms accept it. note, vertices seen by the algorithms are the dense
+// indices, use id() to translate an index back to the original vertex id and
+// index() for the other way around.
+//
+// the arrays are either owned by the graph or viewed from an external storage,
+// e.g. a memory-mapped graph file (see graph_file.hpp). since the graph is
+// immutable, copies share the same storage.
+class CsrGraph {
+ public:
+  // range of the dense vertex indices 0..V-1.
+  class VertexRange {
+   public:
+    class iterator {
+     public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = int;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const int*;
+      using reference = const int&;
+
+      iterator() = default;
+      explicit iterator(const int v) : v{v} {}
+
+      const int& operator*() const { return v; }
+      iterator& operator++() {
+        ++v;
+        return *this;
+      }
+      iterator operator++(int) { return iterator(v++); }
+      bool operator==(const iterator& other) const { return v == other.v; }
+      bool operator!=(const iterator& other) const { return v != other.v; }
+
+     private:
+      int v{0};
+    };
+
+    explicit VertexRange(const int n) : n{n} {}
+
+    iterator begin() const { return iterator(0); }
+    iterator end() const { return iterator(n); }
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    int front() const { return 0; }
+
+   private:
+    int n;
+  };
+
+  // range of the outgoing edges of one vertex.
+  // edges are materialized on the fly from the flat arrays.
+  class EdgeRange {
+   public:
+    class iterator {
+     public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Edge;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = Edge;
+
+      iterator() = default;
+      iterator(const int v, const int* target, const int* weight)
+          : v{v}, target{target}, weight{weight} {}
+
+      Edge operator*() const {
+        return Edge{.v = v, .w = *target, .weight = *weight};
+      }
+      iterator& operator++() {
+        ++target;
+        ++weight;
+        return *this;
+      }
+      iterator operator++(int) {
+        iterator it = *this;
+        ++*this;
+        return it;
+      }
+      bool operator==(const iterator& other) const {
+        return target == other.target;
+      }
+      bool operator!=(const iterator& other) const {
+        return target != other.target;
+      }
+
+     private:
+      int v{0};
+      const int* target{nullptr};
+      const int* weight{nullptr};
+    };
+
+    EdgeRange(const int v, const int* targets, const int* weights,
+              const int n)
+        : v{v}, targets{targets}, weights{weights}, n{n} {}
+
+    iterator begin() const { return iterator(v, targets, weights); }
+    iterator end() const { return iterator(v, targets + n, weights + n); }
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+
+   private:
+    int v;
+    const int* targets;
+    const int* weights;
+    int n;
+  };
+
+  CsrGraph() {
+    auto arrays = make_arrays(std::pmr::get_default_resource());
+    arrays->offsets.push_back(0);
+    adopt(std::move(arrays));
+  }
+
+  // freeze an adjacency list graph with int ids and int or NoWeight weights,
+  // e.g. a Graph. the edges of an unweighted graph get weight 1, since the
+  // weight array is int either way.
+  /// @param resource where the arrays and the scratch of the build are
+  /// allocated, e.g. the pool of a Workspace for a snapshot taken per query.
+  /// it must outlive the graph and all its copies.
+  template <typename Weight, typename Directedness>
+  explicit CsrGraph(const BasicGraph<int, Weight, Directedness>& g,
+                    std::pmr::memory_resource* const resource =
+                        std::pmr::get_default_resource()) {
+    static_assert(std::is_same_v<Weight, int> ||
+                      std::is_same_v<Weight, NoWeight>,
+                  "the CSR weights are int, other weight types aren't "
+                  "supported");
+    const std::pmr::list<int>& vertices = g.all_vertices();
+    // the edges are read in place rather than copied by all_edges().
+    build(
+        std::pmr::vector<int>(vertices.cbegin(), vertices.cend(), resource),
+        [&](const auto& fn) {
+          for (const int& v : vertices) {
+            for (const auto& e : g.edges(v)) {
+              if constexpr (std::is_same_v<Weight, int>) {
+                fn(Edge{.v = e.v, .w = e.w, .weight = e.weight});
+              } else {
+                fn(Edge{.v = e.v, .w = e.w, .weight = 1});
+              }
+            }
+          }
+        },
+        resource);
+  }
+
+  // build from an edge list.
+  // vertices not touching any edge have to be given explicitly.
+  explicit CsrGraph(const std::vector<Edge>& edges,
+                    const std::vector<int>& vertices = {}) {
+    std::pmr::memory_resource* const resource =
+        std::pmr::get_default_resource();
+    build(
+        std::pmr::vector<int>(vertices.cbegin(), vertices.cend(), resource),
+        [&](const auto& fn) {
+          for (const Edge& e : edges) {
+            fn(e);
+          }
+        },
+        resource);
+  }
+
+  // view CSR arrays kept alive by the storage without copying them.
+  /// @param storage owner of the memory the arrays point to.
+  /// @param offsets size V + 1, starting from 0 and ending with E.
+  /// @param targets size E.
+  /// @param weights size E.
+  /// @param ids size V, ascending.
+  static CsrGraph view(std::shared_ptr<const void> storage,
+                       const std::span<const int> offsets,
+                       const std::span<const int> targets,
+                       const std::span<const int> weights,
+                       const std::span<const int> ids) {
+    assert(offsets.size() == ids.size() + 1);
+    assert(targets.size() == weights.size());
+    assert(static_cast<std::size_t>(offsets.back()) == targets.size());
+    CsrGraph g;
+    g.storage_ = std::move(storage);
+    g.offsets_ = offsets;
+    g.targets_ = targets;
+    g.weights_ = weights;
+    g.ids_ = ids;
+    return g;
+  }
+
+  int num_vertices() const { return static_cast<int>(ids_.size()); }
+  int num_edges() const { return static_cast<int>(targets_.size()); }
+
+  // #outgoing edges of the vertex v.
+  int degree(const int v) const { return offsets_[v + 1] - offsets_[v]; }
+
+  // the original id of the vertex v.
+  int id(const int v) const { return ids_[v]; }
+
+  // the dense index of the vertex with the original id.
+  /// @return -1 if no vertex has such an id.
+  int index(const int id) const {
+    const auto it = std::lower_bound(ids_.begin(), ids_.end(), id);
+    if (it == ids_.end() || *it != id) {
+      return -1;
+    }
+    return static_cast<int>(it - ids_.begin());
+  }
+
+  VertexRange all_vertices() const { return VertexRange(num_vertices()); }
+
+  EdgeRange edges(const int v) const {
+    const int begin = offsets_[v];
+    return EdgeRange(v, targets_.data() + begin, weights_.data() + begin,
+                     offsets_[v + 1] - begin);
+  }
+
+  // return all edges grouped by the source vertex.
+  std::vector<Edge> all_edges() const {
+    std::vector<Edge> edges;
+    edges.reserve(targets_.size());
+    for (int v = 0; v < num_vertices(); ++v) {
+      for (const Edge& e : this->edges(v)) {
+        edges.push_back(e);
+      }
+    }
+    return edges;
+  }
+
+  // create a graph with all directed edges reversed, i.e. the transpose.
+  // vertices keep their dense indices.
+  /// @param resource the same as for the construction from a BasicGraph.
+  CsrGraph reversed(std::pmr::memory_resource* const resource =
+                        std::pmr::get_default_resource()) const {
+    auto arrays = make_arrays(resource);
+    arrays->ids.assign(ids_.begin(), ids_.end());
+    std::pmr::vector<int>& offsets = arrays->offsets;
+    offsets.assign(num_vertices() + 1, 0);
+    for (const int& w : targets_) {
+      ++offsets[w + 1];
+    }
+    for (int v = 0; v < num_vertices(); ++v) {
+      offsets[v + 1] += offsets[v];
+    }
+    arrays->targets.resize(targets_.size());
+    arrays->weights.resize(weights_.size());
+    std::pmr::vector<int> next(offsets.cbegin(), offsets.cend() - 1, resource);
+    for (int v = 0; v < num_vertices(); ++v) {
+      for (int i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+        const int slot = next[targets_[i]]++;
+        arrays->targets[slot] = v;
+        arrays->weights[slot] = weights_[i];
+      }
+    }
+
+    CsrGraph rg;
+    rg.adopt(std::move(arrays));
+    return rg;
+  }
+
+  // raw CSR arrays, for algorithms that want to scan them directly.
+  std::span<const int> offsets() const { return offsets_; }
+  std::span<const int> targets() const { return targets_; }
+  std::span<const int> weights() const { return weights_; }
+  std::span<const int> ids() const { return ids_; }
+
+  // print the graph using adjacency list representation with original ids.
+  void print() const {
+    for (int v = 0; v < num_vertices(); ++v) {
+      std::cout << id(v) << " -> ";
+      for (int i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+        std::cout << id(targets_[i]) << ' ';
+      }
+      std::cout << '\n';
+    }
+  }
+
+ private:
+  // owned storage of the CSR arrays.
+  struct Arrays {
+    explicit Arrays(std::pmr::memory_resource* const resource)
+        : offsets(resource),
+          targets(resource),
+          weights(resource),
+          ids(resource) {}
+
+    std::pmr::vector<int> offsets;
+    std::pmr::vector<int> targets;
+    std::pmr::vector<int> weights;
+    std::pmr::vector<int> ids;
+  };
+
+  // the arrays and their control block on the resource.
+  static std::shared_ptr<Arrays> make_arrays(
+      std::pmr::memory_resource* const resource) {
+    return std::allocate_shared<Arrays>(
+        std::pmr::polymorphic_allocator<Arrays>(resource), resource);
+  }
+
+  // take the ownership of the arrays and view them.
+  void adopt(std::shared_ptr<Arrays> arrays) {
+    offsets_ = arrays->offsets;
+    targets_ = arrays->targets;
+    weights_ = arrays->weights;
+    ids_ = arrays->ids;
+    storage_ = std::move(arrays);
+  }
+
+  // a counting sort of the edges by the source vertex.
+  // edges of the same source vertex keep their relative order.
+  /// @param for_each_edge for_each_edge(fn) calls fn(e) on each Edge e, the
+  /// same order on each call.
+  template <typename ForEachEdge>
+  void build(std::pmr::vector<int> vertices, ForEachEdge&& for_each_edge,
+             std::pmr::memory_resource* const resource) {
+    for_each_edge([&](const Edge& e) {
+      vertices.push_back(e.v);
+      vertices.push_back(e.w);
+    });
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                   vertices.end());
+    auto arrays = make_arrays(resource);
+    arrays->ids = std::move(vertices);
+    const int n = static_cast<int>(arrays->ids.size());
+
+    // key: original vertex id, value: dense vertex index.
+    std::pmr::unordered_map<int, int> index_of(resource);
+    index_of.reserve(n);
+    for (int v = 0; v < n; ++v) {
+      index_of[arrays->ids[v]] = v;
+    }
+
+    std::pmr::vector<int>& offsets = arrays->offsets;
+    offsets.assign(n + 1, 0);
+    std::size_t num_edges = 0;
+    for_each_edge([&](const Edge& e) {
+      ++offsets[index_of.at(e.v) + 1];
+      ++num_edges;
+    });
+    for (int v = 0; v < n; ++v) {
+      offsets[v + 1] += offsets[v];
+    }
+
+    arrays->targets.resize(num_edges);
+    arrays->weights.resize(num_edges);
+    std::pmr::vector<int> next(offsets.cbegin(), offsets.cend() - 1, resource);
+    for_each_edge([&](const Edge& e) {
+      const int slot = next[index_of.at(e.v)]++;
+      arrays->targets[slot] = index_of.at(e.w);
+      arrays->weights[slot] = e.weight;
+    });
+
+    adopt(std::move(arrays));
+  }
+
+  // keeps the memory viewed by the spans below alive.
+  std::shared_ptr<const void> storage_;
+  // size V + 1. the outgoing edges of the vertex v are in the half-open slot
+  // range [offsets_[v], offsets_[v + 1]).
+  std::span<const int> offsets_;
+  // size E. destination vertex of each edge slot.
+  std::span<const int> targets_;
+  // size E. weight of each edge slot.
+  std::span<const int> weights_;
+  // size V. key: dense vertex index, value: original vertex id, ascending.
+  std::span<const int> ids_;
+};
+
+// the graph g as a CsrGraph, for the algos which keep their per-vertex state
+// in flat arrays. a CsrGraph is returned as is, sharing its storage.
+/// @param resource for the arrays of the copy, the same as for the
+/// construction from a BasicGraph.
+template <typename G>
+CsrGraph as_csr_graph(const G& g, std::pmr::memory_resource* const resource =
+                                      std::pmr::get_default_resource()) {
+  if constexpr (std::is_same_v<G, CsrGraph>) {
+    return g;
+  } else {
+    return CsrGraph(g, resource);
+  }
+}
+
+// translate the dense index v of as_csr_graph(g) back to the vertex of g, so
+// that the results are in the vertices the caller passed in. a CsrGraph's
+// vertices are the dense indices already.
+template <typename G>
+int vertex_of(const CsrGraph& csr, const int v) {
+  if constexpr (std::is_same_v<G, CsrGraph>) {
+    return v;
+  } else {
+    return csr.id(v);
+  }
+}
+
+#endif  // CSR_GRAPH_HPP_
@@ -0,0 +1,281 @@
+#ifndef DELTA_STEPPING_HPP_
+#define DELTA_STEPPING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+
+// parallel single source shortest path by delta-stepping, for computing the
+// full distance vector from one source on a large graph.
+// this algo works as below:
+// (1) vertices are kept in buckets by their tentative distance, the i-th
+//     bucket holding the distances in [i * delta, (i + 1) * delta).
+// (2) edges are split into light ones, weight <= delta, and heavy ones.
+// (3) take the lowest non-empty bucket. relax the light edges of all its
+//     vertices in parallel, which may put vertices back into the same bucket,
+//     and repeat until the bucket stays empty. then relax the heavy edges of
+//     all vertices removed from the bucket once, which never lands in the
+//     same bucket.
+// (4) repeat (3) until all buckets are empty.
+//
+// intuition: Dijkstra settles one vertex at a time, which is inherently
+// sequential. delta-stepping settles a whole bucket at a time, paying with
+// some re-relaxations within a bucket. delta = 1 on integer weights is
+// Dijkstra, and delta = infinity is Bellman-Ford.
+//
+// the output is the same ShortestPathTree as DijkstraEngine::shortest_path_tree
+// so the two can be swapped per query. the distances are identical. the
+// parents form a valid shortest path tree too, but where several shortest
+// paths tie, which one is picked depends on the thread interleaving.
+// negative-weight edges are not supported, same as Dijkstra.
+//
+// a road-like graph has thousands of buckets, each with a few short phases,
+// so the phases run on a ThreadPool kept by the engine, and small frontiers
+// on the calling thread, rather than on threads started per phase.
+class DeltaSteppingEngine {
+ public:
+  // a phase over fewer vertices is processed by the calling thread only.
+  static constexpr std::size_t PARALLEL_FRONTIER = 1 << 10;
+
+  /// @param delta bucket width, or 0 for auto_delta(g).
+  explicit DeltaSteppingEngine(const CsrGraph& g, const int delta = 0,
+                               const int num_threads = hardware_threads())
+      : g{g},
+        delta{delta > 0 ? delta : auto_delta(g)},
+        num_threads{std::max(1, num_threads)},
+        state(std::make_unique<std::atomic<uint64_t>[]>(g.num_vertices())),
+        removed_in(std::make_unique<std::atomic<int>[]>(g.num_vertices())),
+        pool(this->num_threads > 1
+                 ? std::make_unique<ThreadPool>(this->num_threads)
+                 : nullptr) {
+    for (std::size_t t = 0; t < static_cast<std::size_t>(this->num_threads);
+         ++t) {
+      bins.emplace_back(num_slots());
+    }
+  }
+
+  // the default bucket width: max weight / average degree.
+  // on random weights, a bucket then holds about one expected re-relaxation
+  // per vertex, while there are few enough buckets to keep the threads busy.
+  static int auto_delta(const CsrGraph& g) {
+    const std::span<const int> weights = g.weights();
+    if (g.num_edges() == 0) {
+      return 1;
+    }
+    const int max_weight = *std::max_element(weights.begin(), weights.end());
+    const double avg_degree =
+        static_cast<double>(g.num_edges()) / g.num_vertices();
+    return std::max(1, static_cast<int>(max_weight / avg_degree));
+  }
+
+  int bucket_width() const { return delta; }
+
+  ShortestPathTree shortest_path_tree(const int src) {
+    const int n = g.num_vertices();
+    phase(n, [&](std::size_t begin, std::size_t end, int) {
+      for (std::size_t v = begin; v < end; ++v) {
+        state[v].store(pack(MAX_DIST, -1), std::memory_order_relaxed);
+        removed_in[v].store(-1, std::memory_order_relaxed);
+      }
+    });
+    for (std::vector<std::vector<int>>& slots : bins) {
+      for (std::vector<int>& slot : slots) {
+        slot.clear();
+      }
+    }
+
+    state[src].store(pack(0, -1), std::memory_order_relaxed);
+    bins[0][0].push_back(src);
+    std::vector<int> frontier;
+    std::vector<int> removed;
+    GRAPH_STATS(AlgoStats stats; std::size_t level = 0;
+                thread_stats.assign(num_threads, ThreadStats{});)
+    for (int i = 0; (i = next_bucket(i)) != -1; ++i) {
+      // light phase, until the bucket stays empty.
+      GRAPH_STATS(PhaseTimer light_timer(stats, "light");)
+      removed.clear();
+      for (gather(i, frontier); !frontier.empty(); gather(i, frontier)) {
+        const std::size_t first_new = removed.size();
+        removed.resize(first_new + frontier.size(), -1);
+        phase(frontier.size(),
+              [&](std::size_t begin, std::size_t end, const int t) {
+                for (std::size_t k = begin; k < end; ++k) {
+                  const int v = frontier[k];
+                  // a stale entry, v moved to a lower bucket.
+                  if (dist(v) / delta != i) {
+                    GRAPH_STATS(++thread_stats[t].stats.stale_pops;)
+                    continue;
+                  }
+                  // remember v once for the heavy phase.
+                  if (removed_in[v].exchange(i, std::memory_order_relaxed) !=
+                      i) {
+                    removed[first_new + k] = v;
+                  }
+                  relax_edges(v, t, /*light=*/true);
+                }
+              });
+      }
+      removed.erase(std::remove(removed.begin(), removed.end(), -1),
+                    removed.end());
+      // the removed vertices have their final distances now.
+      GRAPH_STATS(light_timer.stop();
+                  stats.add_frontier(level++, removed.size());
+                  PhaseTimer heavy_timer(stats, "heavy");)
+
+      // heavy phase, once with the final distances of the bucket.
+      phase(removed.size(),
+            [&](std::size_t begin, std::size_t end, const int t) {
+              for (std::size_t k = begin; k < end; ++k) {
+                relax_edges(removed[k], t, /*light=*/false);
+              }
+            });
+    }
+
+    ShortestPathTree tree;
+    tree.src = src;
+    tree.dist.resize(n);
+    tree.parent.resize(n);
+    phase(n, [&](std::size_t begin, std::size_t end, int) {
+      for (std::size_t v = begin; v < end; ++v) {
+        const uint64_t s = state[v].load(std::memory_order_relaxed);
+        tree.dist[v] = dist_of(s);
+        tree.parent[v] = parent_of(s);
+      }
+    });
+    GRAPH_STATS(for (const ThreadStats& s : thread_stats) { stats += s.stats; }
+                for (const uint64_t& size : stats.frontier_sizes) {
+                  stats.vertices_settled += size;
+                }
+                tree.stats = std::move(stats);)
+    return tree;
+  }
+
+  const CsrGraph& graph() const { return g; }
+
+ private:
+  // {dist, parent} packed into one word so that both are updated by one CAS.
+  static uint64_t pack(const int dist, const int parent) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(dist)) << 32 |
+           static_cast<uint32_t>(parent);
+  }
+  static int dist_of(const uint64_t s) { return static_cast<int>(s >> 32); }
+  static int parent_of(const uint64_t s) {
+    return static_cast<int>(static_cast<uint32_t>(s));
+  }
+
+  // fn(begin, end, t) over [0, n) on the pool, t being the worker, or on the
+  // calling thread as the thread 0 if n is below PARALLEL_FRONTIER.
+  void phase(const std::size_t n,
+             const std::function<void(std::size_t, std::size_t, int)>& fn) {
+    if (pool && n >= PARALLEL_FRONTIER) {
+      pool->parallel_for(n, fn);
+    } else if (n > 0) {
+      fn(0, n, 0);
+    }
+  }
+
+  int dist(const int v) const {
+    return dist_of(state[v].load(std::memory_order_relaxed));
+  }
+
+  // a pending vertex is at most max weight / delta buckets ahead of the
+  // current one, so the buckets are kept in a cyclic array of that many
+  // slots.
+  std::size_t num_slots() const {
+    const std::span<const int> weights = g.weights();
+    const int max_weight =
+        weights.empty() ? 0 : *std::max_element(weights.begin(), weights.end());
+    return static_cast<std::size_t>(max_weight / delta) + 2;
+  }
+
+  // relax the light or heavy edges of v, putting the improved vertices into
+  // the bins of the thread t.
+  void relax_edges(const int v, const int t, const bool light) {
+    const std::span<const int> offsets = g.offsets();
+    const std::span<const int> targets = g.targets();
+    const std::span<const int> weights = g.weights();
+    std::vector<std::vector<int>>& slots = bins[t];
+
+    const int dist_to_v = dist(v);
+    for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+      if ((weights[e] <= delta) != light) {
+        continue;
+      }
+      const int w = targets[e];
+      const int d = dist_to_v + weights[e];
+      GRAPH_STATS(++thread_stats[t].stats.edges_scanned;)
+      uint64_t old = state[w].load(std::memory_order_relaxed);
+      // only a strict improvement takes over the parent, which keeps the
+      // parents acyclic even with zero-weight edges.
+      while (d < dist_of(old)) {
+        if (state[w].compare_exchange_weak(old, pack(d, v),
+                                           std::memory_order_relaxed)) {
+          slots[(d / delta) % slots.size()].push_back(w);
+          GRAPH_STATS(++thread_stats[t].stats.edges_relaxed;)
+          break;
+        }
+      }
+    }
+  }
+
+  // the lowest non-empty bucket >= i, or -1 if all are empty.
+  int next_bucket(const int i) const {
+    const std::size_t k = bins[0].size();
+    for (std::size_t j = 0; j < k; ++j) {
+      for (const std::vector<std::vector<int>>& slots : bins) {
+        if (!slots[(i + j) % k].empty()) {
+          return i + static_cast<int>(j);
+        }
+      }
+    }
+    return -1;
+  }
+
+  // move the entries of the bucket i from all threads' bins into frontier.
+  // a few copies, so on the calling thread.
+  void gather(const int i, std::vector<int>& frontier) {
+    const std::size_t slot = i % bins[0].size();
+    frontier.clear();
+    for (std::vector<std::vector<int>>& slots : bins) {
+      frontier.insert(frontier.end(), slots[slot].begin(), slots[slot].end());
+      slots[slot].clear();
+    }
+  }
+
+  // a copy is cheap since it shares the storage of the graph.
+  const CsrGraph g;
+  const int delta;
+  const int num_threads;
+  // key: vertex, value: packed {dist, parent}.
+  std::unique_ptr<std::atomic<uint64_t>[]> state;
+  // key: vertex, value: the last bucket it was removed from.
+  std::unique_ptr<std::atomic<int>[]> removed_in;
+  // bins[t][slot]: vertices put into the bucket of the slot by the thread t.
+  std::vector<std::vector<std::vector<int>>> bins;
+  // per-thread counters of the current run.
+  GRAPH_STATS(std::vector<ThreadStats> thread_stats;)
+  // the workers of the phases, key: thread id. none if single-threaded.
+  std::unique_ptr<ThreadPool> pool;
+};
+
+// one-shot wrapper.
+/// @param delta bucket width, or 0 for the auto-tuned default.
+ShortestPathTree delta_stepping_sssp(
+    const CsrGraph& g, const int src, const int delta = 0,
+    const int num_threads = hardware_threads()) {
+  return DeltaSteppingEngine(g, delta, num_threads).shortest_path_tree(src);
+}
+
+#endif  // DELTA_STEPPING_HPP_
@@ -0,0 +1,180 @@
+#ifndef DFS_HPP_
+#define DFS_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "stats.hpp"
+
+// iterative DFS engine shared by the DFS based algorithms.
+// compared to a recursive dfs, the call stack is an explicit vector of
+// {vertex, next edge slot} frames, so a 1M-vertex chain costs 8MB of heap
+// instead of overflowing the thread stack. and the visited/ancestor sets and
+// the parent mapping are flat arrays over the dense vertex indices.
+//
+// the algorithms plug in through a visitor. the engine classifies each edge
+// v -> w it scans by the state of w:
+// - tree edge: w is unvisited, and w becomes a child of v.
+// - back edge: w is active, i.e. an ancestor of v on the stack, which closes
+//   a cycle w -> ... -> v -> w.
+// - forward or cross edge: w is finished, i.e. in the subtree of v or in
+//   another subtree.
+// a visitor derives from DfsVisitor and hides the hooks it needs. the hooks
+// are resolved at compile time, so the unused ones cost nothing.
+
+// no-op hooks.
+struct DfsVisitor {
+  // v is visited the first time, i.e. DFS preorder.
+  void discover(int) {}
+  // all edges of v are scanned and all its descendants finished, i.e. DFS
+  // postorder.
+  void finish(int) {}
+  void tree_edge(int, int) {}
+  void back_edge(int, int) {}
+  void forward_or_cross_edge(int, int) {}
+  // checked after each hook. true stops the search.
+  bool stop() const { return false; }
+};
+
+class DfsEngine {
+ public:
+  enum class State : uint8_t { unvisited, active, finished };
+
+  /// @param resource where the per-vertex arrays and the stack are
+  /// allocated, e.g. the pool of a Workspace.
+  explicit DfsEngine(const CsrGraph& g,
+                     std::pmr::memory_resource* const resource =
+                         std::pmr::get_default_resource())
+      : g{g},
+        state_(g.num_vertices(), resource),
+        parent_(g.num_vertices(), resource),
+        stack(resource) {
+    reset();
+  }
+
+  // mark all vertices unvisited.
+  void reset() {
+    std::fill(state_.begin(), state_.end(), State::unvisited);
+    std::fill(parent_.begin(), parent_.end(), -1);
+  }
+
+  // DFS from root over the vertices not visited by earlier runs since the
+  // last reset. nothing happens if root is visited already.
+  /// @return false if the visitor stopped the search.
+  template <typename Visitor>
+  bool run(const int root, Visitor& visitor) {
+    if (state_[root] != State::unvisited) {
+      return true;
+    }
+    const std::span<const int> offsets = g.offsets();
+    const std::span<const int> targets = g.targets();
+
+    stack.clear();
+    state_[root] = State::active;
+    GRAPH_STATS(++stats_.vertices_settled;)
+    visitor.discover(root);
+    if (visitor.stop()) {
+      return false;
+    }
+    stack.push_back(Frame{.v = root, .next = offsets[root]});
+    while (!stack.empty()) {
+      Frame& f = stack.back();
+      const int v = f.v;
+      if (f.next == offsets[v + 1]) {
+        stack.pop_back();
+        state_[v] = State::finished;
+        visitor.finish(v);
+        if (visitor.stop()) {
+          return false;
+        }
+        continue;
+      }
+
+      const int w = targets[f.next++];
+      GRAPH_STATS(++stats_.edges_scanned;)
+      switch (state_[w]) {
+        case State::unvisited:
+          visitor.tree_edge(v, w);
+          parent_[w] = v;
+          state_[w] = State::active;
+          GRAPH_STATS(++stats_.vertices_settled;)
+          visitor.discover(w);
+          // f is not used after the push, which may reallocate the stack.
+          stack.push_back(Frame{.v = w, .next = offsets[w]});
+          break;
+        case State::active:
+          visitor.back_edge(v, w);
+          break;
+        case State::finished:
+          visitor.forward_or_cross_edge(v, w);
+          break;
+      }
+      if (visitor.stop()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // run from each unvisited vertex in the index order.
+  /// @param on_root on_root(root) is called before each run, e.g. to start a
+  /// new component.
+  /// @return false if the visitor stopped the search.
+  template <typename Visitor, typename OnRoot>
+  bool run_all(Visitor& visitor, OnRoot&& on_root) {
+    for (int v = 0; v < g.num_vertices(); ++v) {
+      if (state_[v] == State::unvisited) {
+        on_root(v);
+        if (!run(v, visitor)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  template <typename Visitor>
+  bool run_all(Visitor& visitor) {
+    return run_all(visitor, [](int) {});
+  }
+
+  State state(const int v) const { return state_[v]; }
+  // the parent in the DFS forest, or -1 for roots and unvisited vertices.
+  int parent(const int v) const { return parent_[v]; }
+
+  // the tree path from the ancestor a down to v.
+  std::vector<int> tree_path(const int a, const int v) const {
+    std::vector<int> path;
+    for (int x = v; x != a; x = parent_[x]) {
+      path.push_back(x);
+    }
+    path.push_back(a);
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+  const CsrGraph& graph() const { return g; }
+
+  // the vertices discovered and the edges scanned since the construction,
+  // see stats.hpp.
+  const AlgoStats& stats() const { return stats_; }
+
+ private:
+  struct Frame {
+    int v;
+    // the next edge slot of v to scan.
+    int next;
+  };
+
+  // a copy is cheap since it shares the storage of the graph.
+  const CsrGraph g;
+  std::pmr::vector<State> state_;
+  std::pmr::vector<int> parent_;
+  std::pmr::vector<Frame> stack;
+  [[no_unique_address]] AlgoStats stats_;
+};
+
+#endif  // DFS_HPP_
@@ -0,0 +1,227 @@
+#ifndef DIJKSTRA_ENGINE_HPP_
+#define DIJKSTRA_ENGINE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "indexed_heap.hpp"
+#include "shortest_path_tree.hpp"
+#include "stats.hpp"
+
+// Dijkstra engine for serving many shortest path queries on one CsrGraph.
+// compared to dijkstra_sssp, it
+// (1) keeps the dist/parent/settled arrays and the heap allocated between
+//     queries in a workspace, and resets them in O(1) by generation counters,
+//     so a query only pays for the vertices it touches.
+// (2) uses an indexed d-ary heap with decrease-key, so each vertex is in the
+//     heap at most once and no stale entries are popped.
+// (3) returns the distances and paths as data, and stops as soon as the sink
+//     is settled.
+
+// per-query state of a Dijkstra search over dense vertex ids.
+// a slot is valid in the current query iff its stamp equals the current
+// generation, so starting a new query only bumps the generation.
+class DijkstraWorkspace {
+ public:
+  DijkstraWorkspace() = default;
+  explicit DijkstraWorkspace(const int n) { resize(n); }
+
+  void resize(const int n) {
+    heap.clear();
+    heap.resize(n);
+    dist_.assign(n, MAX_DIST);
+    parent_.assign(n, -1);
+    touched_.assign(n, 0);
+    settled_.assign(n, 0);
+    gen = 1;
+  }
+
+  int num_vertices() const { return static_cast<int>(dist_.size()); }
+
+  // invalidate all slots for a new query.
+  void reset() {
+    heap.clear();
+    GRAPH_STATS(stats.clear();)
+    if (++gen == 0) {
+      // the generation wrapped around, old stamps may collide.
+      std::fill(touched_.begin(), touched_.end(), 0);
+      std::fill(settled_.begin(), settled_.end(), 0);
+      gen = 1;
+    }
+  }
+
+  int dist(const int v) const {
+    return touched_[v] == gen ? dist_[v] : MAX_DIST;
+  }
+  int parent(const int v) const {
+    return touched_[v] == gen ? parent_[v] : -1;
+  }
+  bool settled(const int v) const { return settled_[v] == gen; }
+
+  void set(const int v, const int dist, const int parent) {
+    touched_[v] = gen;
+    dist_[v] = dist;
+    parent_[v] = parent;
+  }
+  void settle(const int v) { settled_[v] = gen; }
+
+  // the frontier. the key of a vertex is its tentative distance.
+  IndexedHeap<int, 4> heap;
+  // of the current query.
+  [[no_unique_address]] AlgoStats stats;
+
+ private:
+  std::vector<int> dist_;
+  std::vector<int> parent_;
+  // generation in which the dist/parent slot was written.
+  std::vector<uint32_t> touched_;
+  // generation in which the vertex was settled.
+  std::vector<uint32_t> settled_;
+  uint32_t gen{1};
+};
+
+// one Dijkstra step: settle the vertex with the lowest heap key and relax its
+// outgoing edges.
+// shared by all searches built on the workspace, which differ in
+// - key(w, d): the heap key of the vertex w with the tentative distance d,
+//   e.g. d itself for Dijkstra, or d plus a lower bound to the sink for A*.
+// - on_scan(w, d): called on each scanned edge v -> w with d = dist(v) +
+//   weight, e.g. to find where a bidirectional search meets.
+/// @return the settled vertex.
+template <typename Key, typename OnScan>
+int dijkstra_settle_next(const CsrGraph& g, DijkstraWorkspace& ws, Key&& key,
+                         OnScan&& on_scan) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> weights = g.weights();
+
+  const int v = ws.heap.pop();
+  ws.settle(v);
+  GRAPH_STATS(++ws.stats.heap_pops; ++ws.stats.vertices_settled;
+              ws.stats.edges_scanned += offsets[v + 1] - offsets[v];)
+  const int dist_to_v = ws.dist(v);
+  for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+    const int w = targets[i];
+    const int d = dist_to_v + weights[i];
+    on_scan(w, d);
+    // a settled vertex already has its shortest distance since there's no
+    // negative-weight edge.
+    if (ws.settled(w)) {
+      continue;
+    }
+    if (d < ws.dist(w)) {
+      ws.set(w, d, v);
+      ws.heap.push_or_decrease(w, key(w, d));
+      GRAPH_STATS(++ws.stats.edges_relaxed; ++ws.stats.heap_pushes;)
+    }
+  }
+  return v;
+}
+
+int dijkstra_settle_next(const CsrGraph& g, DijkstraWorkspace& ws) {
+  return dijkstra_settle_next(
+      g, ws, [](int, const int d) { return d; }, [](int, int) {});
+}
+
+class DijkstraEngine {
+ public:
+  explicit DijkstraEngine(const CsrGraph& g) : g{g}, ws(g.num_vertices()) {}
+
+  // search from src until dst is settled, or until all vertices reachable
+  // from src are settled if dst is -1.
+  /// @return false if dst is not reachable from src.
+  bool run(const int src, const int dst = -1) {
+    start(src);
+    while (!ws.heap.empty()) {
+      if (dijkstra_settle_next(g, ws) == dst) {
+        return true;
+      }
+    }
+    return dst == -1;
+  }
+
+  // search from src until all of dsts are settled, i.e. one search serves
+  // all of them and stops at the farthest one. duplicates are fine.
+  /// @return false if any of dsts is not reachable from src.
+  bool run(const int src, const std::span<const int> dsts) {
+    start(src);
+    bool all_found = true;
+    for (const int& dst : dsts) {
+      // the search resumes where the previous dst stopped it.
+      while (!ws.settled(dst) && !ws.heap.empty()) {
+        dijkstra_settle_next(g, ws);
+      }
+      all_found = all_found && ws.settled(dst);
+    }
+    return all_found;
+  }
+
+  // results of the last run.
+  // note, if the last run stopped early at its dst, only the vertices settled
+  // before dst have their final distances.
+  int src() const { return src_; }
+  int dist(const int v) const { return ws.dist(v); }
+  int parent(const int v) const { return ws.parent(v); }
+  bool settled(const int v) const { return ws.settled(v); }
+
+  // src -> ... -> dst of the last run. empty if dst is not settled.
+  std::vector<int> path(const int dst) const {
+    if (!ws.settled(dst)) {
+      return {};
+    }
+    std::vector<int> path;
+    for (int x = dst; x != -1; x = ws.parent(x)) {
+      path.push_back(x);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+  // source-sink shortest path with early exit at dst.
+  ShortestPath shortest_path(const int src, const int dst) {
+    if (!run(src, dst)) {
+      return {};
+    }
+    ShortestPath sp{.found = true, .dist = dist(dst), .path = path(dst)};
+    GRAPH_STATS(sp.stats = ws.stats;)
+    return sp;
+  }
+
+  // full single source shortest path tree.
+  ShortestPathTree shortest_path_tree(const int src) {
+    run(src);
+    ShortestPathTree tree;
+    tree.src = src;
+    tree.dist.resize(g.num_vertices());
+    tree.parent.resize(g.num_vertices());
+    for (int v = 0; v < g.num_vertices(); ++v) {
+      tree.dist[v] = ws.dist(v);
+      tree.parent[v] = ws.parent(v);
+    }
+    GRAPH_STATS(tree.stats = ws.stats;)
+    return tree;
+  }
+
+  const CsrGraph& graph() const { return g; }
+  DijkstraWorkspace& workspace() { return ws; }
+
+ private:
+  void start(const int src) {
+    ws.reset();
+    src_ = src;
+    ws.set(src, 0, -1);
+    ws.heap.push_or_decrease(src, 0);
+    GRAPH_STATS(++ws.stats.heap_pushes;)
+  }
+
+  // a copy is cheap since it shares the storage of the graph, and it stays
+  // valid even if the graph passed in goes away.
+  const CsrGraph g;
+  DijkstraWorkspace ws;
+  int src_{-1};
+};
+
+#endif  // DIJKSTRA_ENGINE_HPP_
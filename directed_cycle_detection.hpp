@@ -1,14 +1,13 @@
 #ifndef DIRECTED_CYCLE_DETECTION_HPP_
 #define DIRECTED_CYCLE_DETECTION_HPP_
 
-#include <cassert>
 #include <iostream>
-#include <stack>
-#include <unordered_map>
 #include <vector>
 
+#include "csr_graph.hpp"
+#include "dfs.hpp"
 #include "graph.hpp"
-#include "union_find.hpp"
+#include "workspace.hpp"
 
 // algorithms for detecting a cycle in a directed graph, i.e. check if the given
 // graph is an directed acyclic graph (DAG).
@@ -18,69 +17,53 @@
 // assume the current vertex is v and the ancenstor vertex is w.
 // such a back edge indicates that there's a path v -> w and also a path w - v
 // and hence a cycle.
-bool dfs(const Graph& g, const int& v, std::unordered_set<int>& visited,
-         std::unordered_set<int>& ancestors,
-         std::unordered_map<int, int>& parent) {
-  visited.insert(v);
-  ancestors.insert(v);  // ancestors of the vertex w.
-
-  for (const Edge& e : g.edges(v)) {
-    const int& w = e.w;
-    // find a tree edge, i.e. from parent to child.
-    if (visited.count(w) == 0) {
-      parent[w] = v;
-      if (dfs(g, w, visited, ancestors, parent)) {
-        return true;
-      }
-    } else if (ancestors.count(w) > 0) {
-      // find a back edge, i.e. from child to ancestor.
-      // this means there's a cycle:
-      // w -> ... -> v -> w.
-
-      // print the cycle.
-      std::stack<int> cycle;
-      cycle.push(w);
-      for (int x = v; x != w; x = parent.at(x)) {
-        cycle.push(x);
-      }
-      cycle.push(w);
-      while (!cycle.empty()) {
-        std::cout << cycle.top() << " -> ";
-        cycle.pop();
-      }
-      std::cout << '\n';
-
-      return true;
+// the other edges the DFS sees are not in our concern. the vertex w is then
+// visited and not an ancestor, and there're two possibilities:
+// (1) cross edge: w is in another subtree.
+// (2) forward edge: w is in the subtree.
+/// @return the cycle w -> ... -> v -> w, listed without repeating w, or
+/// empty if there's none. vertices are those of g.
+template <typename G>
+std::vector<int> dfs_find_cycle(const G& g,
+                                Workspace& ws = Workspace::for_this_thread()) {
+  const CsrGraph csr = as_csr_graph(g, ws.resource());
+  DfsEngine engine(csr, ws.resource());
+  struct Visitor : DfsVisitor {
+    void back_edge(const int v, const int w) {
+      from = v;
+      to = w;
     }
-    // otherwise, the vertex w is a visited vertex and not an ancestor.
-    // there're two possibilities:
-    // (1) cross edge: w is in another subtree.
-    // (2) forward edge: w is in the subtree.
-    // but these edges are not in our concern.
+    bool stop() const { return from != -1; }
+    // the back edge found.
+    int from;
+    int to;
+  } visitor{{}, -1, -1};
+  if (engine.run_all(visitor)) {
+    return {};
   }
 
-  // ancestors form a stack and hence we need to pop the top of the stack per
-  // the system stack.
-  ancestors.erase(v);
-  return false;
+  // the ancestors of v up to w are on the tree path w -> ... -> v.
+  std::vector<int> cycle = engine.tree_path(visitor.to, visitor.from);
+  for (int& x : cycle) {
+    x = vertex_of<G>(csr, x);
+  }
+  return cycle;
 }
 
-bool dfs_detect_cycle(const Graph& g) {
-  std::unordered_set<int> visited;  // visited vertices.
-
-  for (const int& v : g.all_vertices()) {
-    // ancestors of the currently visiting vertex.
-    std::unordered_set<int> ancestors;
-    // key: current vertex, val: the parent vertex of this vertex.
-    std::unordered_map<int, int> parent;
+template <typename G>
+bool dfs_detect_cycle(const G& g,
+                      Workspace& ws = Workspace::for_this_thread()) {
+  const std::vector<int> cycle = dfs_find_cycle(g, ws);
+  if (cycle.empty()) {
+    return false;
+  }
 
-    if (visited.count(v) == 0) {
-      if (dfs(g, v, visited, ancestors, parent)) {
-        return true;
-      }
-    }
+  // print the cycle.
+  for (const int& x : cycle) {
+    std::cout << x << " -> ";
   }
-  return false;
+  std::cout << cycle.front() << " -> " << '\n';
+  return true;
 }
 
 #endif  // DIRECTED_CYCLE_DETECTION_HPP_
\ No newline at end of file
@@ -0,0 +1,210 @@
+#ifndef DYNAMIC_CONNECTIVITY_HPP_
+#define DYNAMIC_CONNECTIVITY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+#include "id_map.hpp"
+#include "union_find.hpp"
+
+// offline fully dynamic connectivity of an undirected graph, for a replay log
+// of edge insertions, edge deletions and queries.
+// the operations are recorded first, and solve() answers all queries at once.
+// this algo works as below:
+// (1) each edge is alive during an interval of queries, from the first query
+//     after its insertion up to the last query before its deletion.
+// (2) split the query indices into a segment tree, and hang each interval on
+//     the O(log Q) nodes covering it, like a range update.
+// (3) DFS the segment tree with a RollbackUF. on entering a node, union the
+//     edges hanging there. at a leaf, all edges alive at that query and only
+//     those are unioned, so answer it. on leaving a node, roll back its
+//     unions.
+// each edge is unioned O(log Q) times, and each union or find costs
+// O(log V), so O((V + E + Q) log Q log V) overall.
+//
+// intuition: union-find can't delete, but it can undo its latest unions. the
+// segment tree orders the work so that only the latest unions are ever
+// deleted.
+//
+// queries mirror the UF interface: query_connected is UF::is_connected and
+// query_cc_cnt is UF::get_cc_cnt at that point of the log. each returns the
+// slot of its answer in the vector returned by solve().
+class OfflineDynamicConnectivity {
+ public:
+  OfflineDynamicConnectivity() = default;
+
+  // add the vertex v, if new, as a component by itself.
+  void add_vertex(const int v) { ids.intern(v); }
+
+  // add the undirected edge v - w, and its vertices if new. a multi-edge is
+  // alive until all its copies are removed.
+  void add_edge(const int v, const int w) {
+    const int x = ids.intern(v);
+    const int y = ids.intern(w);
+    open[key(x, y)].push_back(num_queries());
+  }
+  void add_edge(const Edge& e) { add_edge(e.v, e.w); }
+
+  // remove one copy of the undirected edge v - w.
+  /// @return false if there's no such edge.
+  bool remove_edge(const int v, const int w) {
+    const int x = ids.index(v);
+    const int y = ids.index(w);
+    if (x == -1 || y == -1) {
+      return false;
+    }
+    const auto it = open.find(key(x, y));
+    if (it == open.end() || it->second.empty()) {
+      return false;
+    }
+    const int begin = it->second.back();
+    it->second.pop_back();
+    if (begin < num_queries()) {
+      intervals.push_back(Interval{.x = x, .y = y, .begin = begin,
+                                   .end = num_queries()});
+    }
+    return true;
+  }
+  bool remove_edge(const Edge& e) { return remove_edge(e.v, e.w); }
+
+  // whether v and w are connected at this point.
+  /// @return the slot of the answer, 1 if connected and 0 otherwise.
+  int query_connected(const int v, const int w) {
+    const int x = ids.index(v);
+    const int y = ids.index(w);
+    queries.push_back(Query{.x = x, .y = y, .num_vertices = ids.size()});
+    if (x == -1 || y == -1) {
+      // not a vertex yet, so only connected to itself.
+      queries.back().x = v == w ? ANSWERED_TRUE : ANSWERED_FALSE;
+    }
+    return num_queries() - 1;
+  }
+
+  // #connected components at this point.
+  /// @return the slot of the answer.
+  int query_cc_cnt() {
+    queries.push_back(Query{.x = CC_CNT, .y = 0, .num_vertices = ids.size()});
+    return num_queries() - 1;
+  }
+
+  int num_queries() const { return static_cast<int>(queries.size()); }
+
+  // answer all queries recorded so far. recording may go on afterwards.
+  /// @return key: query slot, value: answer.
+  std::vector<int> solve() const {
+    const int q = num_queries();
+    std::vector<int> answers(q, 0);
+    if (q == 0) {
+      return answers;
+    }
+
+    // key: segment tree node, value: the edges alive for all its queries.
+    // node 1 covers [0, q), and node i covers the halves 2i and 2i + 1.
+    std::vector<std::vector<std::pair<int, int>>> hung(4 * q);
+    for (const Interval& in : intervals) {
+      hang(hung, 1, 0, q, in);
+    }
+    for (const auto& [k, begins] : open) {
+      const int x = static_cast<int>(k >> 32);
+      const int y = static_cast<int>(static_cast<uint32_t>(k));
+      for (const int& begin : begins) {
+        if (begin < q) {
+          hang(hung, 1, 0, q,
+               Interval{.x = x, .y = y, .begin = begin, .end = q});
+        }
+      }
+    }
+
+    RollbackUF uf(ids.size());
+    visit(hung, uf, 1, 0, q, answers);
+    return answers;
+  }
+
+ private:
+  // Query::x tags for the queries which are not connectivity queries.
+  static constexpr int CC_CNT = -1;
+  static constexpr int ANSWERED_FALSE = -2;
+  static constexpr int ANSWERED_TRUE = -3;
+
+  struct Query {
+    // the dense vertices, or x is a tag as above.
+    int x;
+    int y;
+    // #vertices added before the query.
+    int num_vertices;
+  };
+
+  // the edge x - y is alive for the queries [begin, end).
+  struct Interval {
+    int x;
+    int y;
+    int begin;
+    int end;
+  };
+
+  // key identifying the undirected edge, the same as Edge::key.
+  static uint64_t key(const int x, const int y) {
+    return Edge::make(x, y).key();
+  }
+
+  static void hang(std::vector<std::vector<std::pair<int, int>>>& hung,
+                   const int node, const int lo, const int hi,
+                   const Interval& in) {
+    if (in.end <= lo || hi <= in.begin) {
+      return;
+    }
+    if (in.begin <= lo && hi <= in.end) {
+      hung[node].emplace_back(in.x, in.y);
+      return;
+    }
+    const int mid = lo + (hi - lo) / 2;
+    hang(hung, 2 * node, lo, mid, in);
+    hang(hung, 2 * node + 1, mid, hi, in);
+  }
+
+  void visit(const std::vector<std::vector<std::pair<int, int>>>& hung,
+             RollbackUF& uf, const int node, const int lo, const int hi,
+             std::vector<int>& answers) const {
+    const std::size_t s = uf.snapshot();
+    for (const auto& [x, y] : hung[node]) {
+      uf.union_vertices(x, y);
+    }
+    if (hi - lo == 1) {
+      const Query& query = queries[lo];
+      switch (query.x) {
+        case CC_CNT:
+          // the vertices added later are components by themselves, and
+          // have no edge yet.
+          answers[lo] = uf.get_cc_cnt() - (ids.size() - query.num_vertices);
+          break;
+        case ANSWERED_FALSE:
+          answers[lo] = 0;
+          break;
+        case ANSWERED_TRUE:
+          answers[lo] = 1;
+          break;
+        default:
+          answers[lo] = uf.is_connected(query.x, query.y);
+      }
+    } else {
+      const int mid = lo + (hi - lo) / 2;
+      visit(hung, uf, 2 * node, lo, mid, answers);
+      visit(hung, uf, 2 * node + 1, mid, hi, answers);
+    }
+    uf.rollback(s);
+  }
+
+  IdMap<int> ids;
+  std::vector<Query> queries;
+  // the edges removed already.
+  std::vector<Interval> intervals;
+  // key: edge key, value: the first query after each insertion of a copy
+  // not removed yet.
+  std::unordered_map<uint64_t, std::vector<int>> open;
+};
+
+#endif  // DYNAMIC_CONNECTIVITY_HPP_
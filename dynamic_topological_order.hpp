@@ -0,0 +1,230 @@
+#ifndef DYNAMIC_TOPOLOGICAL_ORDER_HPP_
+#define DYNAMIC_TOPOLOGICAL_ORDER_HPP_
+
+#include <algorithm>
+#include <vector>
+
+#include "graph.hpp"
+#include "id_map.hpp"
+#include "topological_sorting.hpp"
+
+// online topological order of a DAG under edge insertions, after Pearce and
+// Kelly. each vertex v has a position ord[v] in the order, and an edge
+// v -> w is in order iff ord[v] < ord[w].
+// inserting an edge x -> y that is out of order works as below:
+// (1) forward DFS from y over the vertices with ord < ord[x]. reaching x
+//     means the path y -> ... -> x exists, so x -> y closes a cycle and is
+//     rejected.
+// (2) backward DFS from x over the vertices with ord > ord[y].
+// (3) only the vertices found are in the wrong order: those of (2) must move
+//     before those of (1). they take over their own positions, sorted, the
+//     vertices of (2) first, each group keeping its relative order.
+//
+// intuition: the DFSs never leave the window (ord[y], ord[x]) of the order,
+// so an insertion costs the edges of the affected region only, instead of
+// O(V + E) for sorting the whole graph again. and an edge already in order
+// costs O(1).
+class DynamicTopologicalOrder {
+ public:
+  DynamicTopologicalOrder() = default;
+
+  // start from the edges of g, added as by add_edge in the order of
+  // g.all_edges(), i.e. the edges closing a cycle are rejected.
+  // if g is a DAG, which is the common case, the order is computed at once by
+  // dfs_topological_sorting instead.
+  explicit DynamicTopologicalOrder(const Graph& g) {
+    const std::vector<int> order = dfs_topological_sorting(g);
+    if (order.empty() && !g.all_vertices().empty()) {
+      for (const int& v : g.all_vertices()) {
+        add_vertex(v);
+      }
+      for (const Edge& e : g.all_edges()) {
+        add_edge(e);
+      }
+      return;
+    }
+    for (const int& v : order) {
+      add_vertex(v);
+    }
+    for (const Edge& e : g.all_edges()) {
+      link(ids.index(e.v), ids.index(e.w), e);
+    }
+  }
+
+  // add the vertex v, if new, at the end of the order.
+  void add_vertex(const int v) {
+    if (ids.contains(v)) {
+      return;
+    }
+    ids.intern(v);
+    ord.push_back(static_cast<int>(order_.size()));
+    order_.push_back(v);
+    out.emplace_back();
+    in.emplace_back();
+    visited.push_back(0);
+    parent.push_back(-1);
+    g.add_vertex(v);
+  }
+
+  // add the directed edge e, and its vertices if new, and update the order.
+  /// @return false if e would close a cycle, in which case nothing changes
+  /// except that cycle() tells the cycle.
+  bool add_edge(const Edge& e) {
+    add_vertex(e.v);
+    add_vertex(e.w);
+    const int x = ids.index(e.v);
+    const int y = ids.index(e.w);
+    if (x == y) {
+      cycle_ = {e.v};
+      return false;
+    }
+    if (ord[x] > ord[y] && !reorder(x, y)) {
+      return false;
+    }
+    link(x, y, e);
+    return true;
+  }
+
+  // the vertices in a topological order.
+  const std::vector<int>& order() const { return order_; }
+
+  // the position of the vertex v in order().
+  /// @return -1 if v is not a vertex.
+  int position(const int v) const {
+    const int x = ids.index(v);
+    return x == -1 ? -1 : ord[x];
+  }
+
+  // the cycle the last rejected edge v -> w would have closed, as
+  // w -> ... -> v -> w, listed without repeating w, the same as
+  // dfs_find_cycle.
+  const std::vector<int>& cycle() const { return cycle_; }
+
+  // the graph of the accepted edges.
+  const Graph& graph() const { return g; }
+
+ private:
+  void link(const int x, const int y, const Edge& e) {
+    out[x].push_back(y);
+    in[y].push_back(x);
+    g.add_edge(e);
+  }
+
+  // move the affected region of the new edge x -> y, ord[x] > ord[y], into
+  // order.
+  /// @return false if x -> y closes a cycle.
+  bool reorder(const int x, const int y) {
+    const int lb = ord[y];
+    const int ub = ord[x];
+    std::vector<int> forward;
+    if (!dfs_forward(y, x, ub, forward)) {
+      // the tree path y -> ... -> x found, x -> y closes the cycle.
+      cycle_.clear();
+      for (int v = x; v != y; v = parent[v]) {
+        cycle_.push_back(ids.key(v));
+      }
+      cycle_.push_back(ids.key(y));
+      std::reverse(cycle_.begin(), cycle_.end());
+      for (const int& v : forward) {
+        visited[v] = 0;
+      }
+      return false;
+    }
+    std::vector<int> backward;
+    dfs_backward(x, lb, backward);
+
+    const auto by_ord = [&](const int a, const int b) {
+      return ord[a] < ord[b];
+    };
+    std::sort(forward.begin(), forward.end(), by_ord);
+    std::sort(backward.begin(), backward.end(), by_ord);
+    // the positions held by the affected vertices, handed out ascending to
+    // the backward vertices first and then the forward ones.
+    std::vector<int> slots;
+    slots.reserve(forward.size() + backward.size());
+    for (const int& v : backward) {
+      slots.push_back(ord[v]);
+    }
+    for (const int& v : forward) {
+      slots.push_back(ord[v]);
+    }
+    std::inplace_merge(slots.begin(), slots.begin() + backward.size(),
+                       slots.end());
+    // each affected vertex takes one of their old positions, so writing the
+    // new positions only overwrites theirs.
+    std::size_t i = 0;
+    for (const std::vector<int>* group : {&backward, &forward}) {
+      for (const int& v : *group) {
+        visited[v] = 0;
+        ord[v] = slots[i++];
+        order_[ord[v]] = ids.key(v);
+      }
+    }
+    return true;
+  }
+
+  // the vertices reachable from y with ord < ub, appended to found and
+  // marked visited.
+  /// @return false if x, with ord[x] == ub, is reachable.
+  bool dfs_forward(const int y, const int x, const int ub,
+                   std::vector<int>& found) {
+    std::vector<int> stack{y};
+    visited[y] = 1;
+    found.push_back(y);
+    while (!stack.empty()) {
+      const int v = stack.back();
+      stack.pop_back();
+      for (const int& w : out[v]) {
+        if (w == x) {
+          parent[x] = v;
+          return false;
+        }
+        if (!visited[w] && ord[w] < ub) {
+          visited[w] = 1;
+          parent[w] = v;
+          found.push_back(w);
+          stack.push_back(w);
+        }
+      }
+    }
+    return true;
+  }
+
+  // the vertices reaching x with ord > lb, appended to found and marked
+  // visited. none of them is visited by dfs_forward, or there'd be a cycle.
+  void dfs_backward(const int x, const int lb, std::vector<int>& found) {
+    std::vector<int> stack{x};
+    visited[x] = 1;
+    found.push_back(x);
+    while (!stack.empty()) {
+      const int v = stack.back();
+      stack.pop_back();
+      for (const int& u : in[v]) {
+        if (!visited[u] && ord[u] > lb) {
+          visited[u] = 1;
+          found.push_back(u);
+          stack.push_back(u);
+        }
+      }
+    }
+  }
+
+  // the vertices as dense indices, in the order of addition.
+  IdMap<int> ids;
+  // key: dense index, value: position in order_.
+  std::vector<int> ord;
+  // key: position, value: vertex.
+  std::vector<int> order_;
+  // the accepted edges on the dense indices, for the DFSs. the Graph keeps
+  // them for the callers as well, but its edges are looked up by a map.
+  std::vector<std::vector<int>> out;
+  std::vector<std::vector<int>> in;
+  // key: dense index. scratch of the DFSs, all 0 between the calls.
+  std::vector<char> visited;
+  // key: dense index, value: its parent in the forward DFS tree.
+  std::vector<int> parent;
+  std::vector<int> cycle_;
+  Graph g;
+};
+
+#endif  // DYNAMIC_TOPOLOGICAL_ORDER_HPP_
@@ -0,0 +1,291 @@
+#ifndef FLOYD_WARSHALL_HPP_
+#define FLOYD_WARSHALL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+
+// all pairs shortest paths of a CsrGraph on a dense row-major matrix.
+// compared to floyd_warshall_apsp, the distances are a flat int32 array
+// instead of nested hash maps, and the V^3 loop is blocked and vectorized.
+
+// the result. vertices are the dense indices of the graph.
+struct ApspMatrix {
+  int n{0};
+  // row length, i.e. n rounded up to whole blocks.
+  int stride{0};
+  // dist[v * stride + w] = distance from v to w, or MAX_DIST if unreachable.
+  std::vector<int> dist;
+  // next[v * stride + w] = the vertex after v on the path v -> .. -> w, or -1
+  // if unreachable. empty if paths are not tracked.
+  std::vector<int> next;
+  // true if some vertex is on a negative-weight cycle, in which case the
+  // distances are meaningless.
+  bool negative_cycle{false};
+
+  int at(const int v, const int w) const {
+    return dist[static_cast<std::size_t>(v) * stride + w];
+  }
+
+  // v -> .. -> w. empty if unreachable or paths are not tracked.
+  std::vector<int> path(int v, const int w) const {
+    if (next.empty() || next[static_cast<std::size_t>(v) * stride + w] == -1) {
+      return {};
+    }
+    std::vector<int> path{v};
+    while (v != w) {
+      v = next[static_cast<std::size_t>(v) * stride + w];
+      path.push_back(v);
+    }
+    return path;
+  }
+};
+
+// blocked Floyd-Warshall, after Venkataraman et al.
+// this algo works as below:
+// (1) split the matrix into B x B tiles, nb tiles per side.
+// (2) for each tile index kb, i.e. the middle vertices of the kb-th tile:
+//     (a) run plain Floyd-Warshall inside the diagonal tile (kb, kb).
+//     (b) update the tiles in row kb and column kb from the diagonal tile.
+//     (c) update all other tiles (i, j) from the tiles (i, kb) and (kb, j).
+//     the tiles of each of (b) and (c) are independent of each other and are
+//     updated in parallel.
+//
+// intuition: plain Floyd-Warshall streams the whole V^2 matrix through the
+// cache once per middle vertex. a tile update touches three tiles that fit in
+// the cache and does B^3 work on them, so the memory traffic drops by a factor
+// of about B. the innermost loop is a min-plus over a contiguous tile row,
+// i.e. c[j] = min(c[j], a + b[j]), which maps to AVX2/AVX-512 min and add.
+class BlockedFloydWarshall {
+ public:
+  // tile side. three int32 tiles are 48KB, which fit in L2, and a tile row is
+  // a whole number of AVX-512 vectors.
+  static constexpr int B = 64;
+
+  /// @param track_paths if true, the next matrix is kept for path recovery,
+  /// which doubles the memory and costs a blend per min.
+  explicit BlockedFloydWarshall(const bool track_paths = false,
+                                const int num_threads = hardware_threads())
+      : track_paths{track_paths}, num_threads{std::max(1, num_threads)} {}
+
+  ApspMatrix run(const CsrGraph& g) {
+    const std::span<const int> offsets = g.offsets();
+    const std::span<const int> targets = g.targets();
+    const std::span<const int> weights = g.weights();
+
+    ApspMatrix m;
+    m.n = g.num_vertices();
+    nb = (m.n + B - 1) / B;
+    m.stride = nb * B;
+    stride = m.stride;
+    const std::size_t size = static_cast<std::size_t>(stride) * stride;
+    m.dist.assign(size, MAX_DIST);
+    if (track_paths) {
+      m.next.assign(size, -1);
+    }
+    // the padding vertices are isolated, so they never shorten a path.
+    for (int v = 0; v < stride; ++v) {
+      m.dist[static_cast<std::size_t>(v) * stride + v] = 0;
+      if (track_paths) {
+        m.next[static_cast<std::size_t>(v) * stride + v] = v;
+      }
+    }
+    bool negative = false;
+    for (int v = 0; v < m.n; ++v) {
+      for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+        const std::size_t slot =
+            static_cast<std::size_t>(v) * stride + targets[i];
+        negative = negative || weights[i] < 0;
+        // keep the lightest of parallel edges.
+        if (weights[i] < m.dist[slot]) {
+          m.dist[slot] = weights[i];
+          if (track_paths) {
+            m.next[slot] = targets[i];
+          }
+        }
+      }
+    }
+
+    dist = m.dist.data();
+    next = track_paths ? m.next.data() : nullptr;
+    if (negative) {
+      track_paths ? solve<true, true>() : solve<true, false>();
+    } else {
+      track_paths ? solve<false, true>() : solve<false, false>();
+    }
+
+    for (int v = 0; v < m.n; ++v) {
+      m.negative_cycle = m.negative_cycle || m.at(v, v) < 0;
+    }
+    return m;
+  }
+
+ private:
+  // NEGATIVE: there're negative weights, so MAX_DIST + a negative weight has
+  // to stay MAX_DIST and the distances are clamped above -MAX_DIST to avoid
+  // overflow on negative cycles.
+  // PATHS: the next matrix is tracked.
+  template <bool NEGATIVE, bool PATHS>
+  void solve() {
+    for (int kb = 0; kb < nb; ++kb) {
+      // (a) the diagonal tile.
+      update_in_place<NEGATIVE, PATHS>(kb, kb, kb);
+
+      // (b) row kb and column kb. the tiles (kb, j) then (i, kb).
+      parallel_for(2 * (nb - 1), num_threads,
+                   [&](std::size_t begin, std::size_t end, int) {
+                     for (std::size_t t = begin; t < end; ++t) {
+                       int other = static_cast<int>(t % (nb - 1));
+                       other += other >= kb ? 1 : 0;
+                       if (t < static_cast<std::size_t>(nb - 1)) {
+                         update_in_place<NEGATIVE, PATHS>(kb, other, kb);
+                       } else {
+                         update_in_place<NEGATIVE, PATHS>(other, kb, kb);
+                       }
+                     }
+                   });
+
+      // (c) the rest.
+      const std::size_t rest = static_cast<std::size_t>(nb - 1) * (nb - 1);
+      parallel_for(rest, num_threads,
+                   [&](std::size_t begin, std::size_t end, int) {
+                     for (std::size_t t = begin; t < end; ++t) {
+                       int ib = static_cast<int>(t / (nb - 1));
+                       int jb = static_cast<int>(t % (nb - 1));
+                       ib += ib >= kb ? 1 : 0;
+                       jb += jb >= kb ? 1 : 0;
+                       update<NEGATIVE, PATHS>(ib, jb, kb);
+                     }
+                   });
+    }
+  }
+
+  std::size_t offset(const int row, const int col) const {
+    return static_cast<std::size_t>(row) * stride + col;
+  }
+
+  // tile (ib, jb) by the middle vertices of the tile kb, where the tile may
+  // be (ib, kb) or (kb, jb) itself.
+  // the middle vertex loop is outermost, so that an update in iteration k is
+  // seen by the later iterations. row k and column k don't change in
+  // iteration k without a negative cycle, so in-place is fine.
+  template <bool NEGATIVE, bool PATHS>
+  void update_in_place(const int ib, const int jb, const int kb) {
+    for (int k = kb * B; k < (kb + 1) * B; ++k) {
+      for (int i = ib * B; i < (ib + 1) * B; ++i) {
+        relax_row<NEGATIVE, PATHS>(i, jb * B, k);
+      }
+    }
+  }
+
+  // tile (ib, jb) from the distinct tiles (ib, kb) and (kb, jb).
+  // the source loop is outermost, so that the tile row of c stays in L1
+  // while it is min-plused with all rows of (kb, jb).
+  template <bool NEGATIVE, bool PATHS>
+  void update(const int ib, const int jb, const int kb) {
+    for (int i = ib * B; i < (ib + 1) * B; ++i) {
+      for (int k = kb * B; k < (kb + 1) * B; ++k) {
+        relax_row<NEGATIVE, PATHS>(i, jb * B, k);
+      }
+    }
+  }
+
+  // dist[i][j] = min(dist[i][j], dist[i][k] + dist[k][j]) for the B columns
+  // starting at j0.
+  template <bool NEGATIVE, bool PATHS>
+  void relax_row(const int i, const int j0, const int k) {
+    const int a = dist[offset(i, k)];
+    if (a == MAX_DIST) {
+      return;
+    }
+    int* c = dist + offset(i, j0);
+    const int* b = dist + offset(k, j0);
+    int* nc = PATHS ? next + offset(i, j0) : nullptr;
+    const int nk = PATHS ? next[offset(i, k)] : -1;
+
+#if defined(__AVX512F__)
+    const __m512i va = _mm512_set1_epi32(a);
+    const __m512i vmax = _mm512_set1_epi32(MAX_DIST);
+    const __m512i vmin = _mm512_set1_epi32(-MAX_DIST);
+    const __m512i vnk = _mm512_set1_epi32(nk);
+    for (int j = 0; j < B; j += 16) {
+      const __m512i vb = _mm512_loadu_si512(b + j);
+      __m512i s = _mm512_add_epi32(va, vb);
+      if constexpr (NEGATIVE) {
+        s = _mm512_max_epi32(s, vmin);
+        s = _mm512_mask_mov_epi32(s, _mm512_cmpeq_epi32_mask(vb, vmax), vb);
+      }
+      const __m512i vc = _mm512_loadu_si512(c + j);
+      if constexpr (PATHS) {
+        const __mmask16 better = _mm512_cmplt_epi32_mask(s, vc);
+        const __m512i vn = _mm512_loadu_si512(nc + j);
+        _mm512_storeu_si512(nc + j, _mm512_mask_mov_epi32(vn, better, vnk));
+      }
+      _mm512_storeu_si512(c + j, _mm512_min_epi32(vc, s));
+    }
+#elif defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi32(a);
+    const __m256i vmax = _mm256_set1_epi32(MAX_DIST);
+    const __m256i vmin = _mm256_set1_epi32(-MAX_DIST);
+    const __m256i vnk = _mm256_set1_epi32(nk);
+    for (int j = 0; j < B; j += 8) {
+      const __m256i vb =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+      __m256i s = _mm256_add_epi32(va, vb);
+      if constexpr (NEGATIVE) {
+        s = _mm256_max_epi32(s, vmin);
+        s = _mm256_blendv_epi8(s, vb, _mm256_cmpeq_epi32(vb, vmax));
+      }
+      const __m256i vc =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + j));
+      if constexpr (PATHS) {
+        const __m256i better = _mm256_cmpgt_epi32(vc, s);
+        const __m256i vn =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nc + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(nc + j),
+                            _mm256_blendv_epi8(vn, vnk, better));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + j),
+                          _mm256_min_epi32(vc, s));
+    }
+#else
+    // branch-free so that the compiler can vectorize it for the target.
+    for (int j = 0; j < B; ++j) {
+      int s = a + b[j];
+      if constexpr (NEGATIVE) {
+        s = b[j] == MAX_DIST ? MAX_DIST : std::max(s, -MAX_DIST);
+      }
+      if constexpr (PATHS) {
+        nc[j] = s < c[j] ? nk : nc[j];
+      }
+      c[j] = std::min(c[j], s);
+    }
+#endif
+  }
+
+  const bool track_paths;
+  const int num_threads;
+  // shape and storage of the matrix being solved.
+  int nb{0};
+  int stride{0};
+  int* dist{nullptr};
+  int* next{nullptr};
+};
+
+// one-shot wrapper.
+ApspMatrix blocked_floyd_warshall(const CsrGraph& g,
+                                  const bool track_paths = false,
+                                  const int num_threads = hardware_threads()) {
+  return BlockedFloydWarshall(track_paths, num_threads).run(g);
+}
+
+#endif  // FLOYD_WARSHALL_HPP_
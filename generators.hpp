@@ -0,0 +1,145 @@
+#ifndef GENERATORS_HPP_
+#define GENERATORS_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "graph.hpp"
+
+// synthetic graphs for the benchmarks, as directed edge lists with the vertex
+// ids 0..n-1 and uniform random weights in [1, max_weight].
+// all generators are deterministic for a given seed.
+// note, a vertex without any edge doesn't appear in the edge list, pass the
+// vertices explicitly to keep it, e.g. CsrGraph(edges, vertices).
+
+// the skew of the recursive quadrant choice of rmat_edges. d = 1 - a - b - c.
+// the defaults are those of the Graph500 Kronecker generator.
+struct RmatParams {
+  double a{0.57};
+  double b{0.19};
+  double c{0.19};
+};
+
+// R-MAT, i.e. the stochastic Kronecker graph of a 2x2 initiator.
+// each edge picks one quadrant of the adjacency matrix per bit of the ids,
+// with the probabilities a, b, c, d, so the degrees follow a power law and
+// most edges land among a few hubs, like social and web graphs.
+// the ids are then shuffled as in Graph500, so that the hubs are not the low
+// ids. self loops are redrawn, multi-edges are kept.
+/// @param scale 2^scale vertices.
+/// @param edge_factor #edges per vertex.
+std::vector<Edge> rmat_edges(const int scale, const int edge_factor,
+                             const uint64_t seed = 1,
+                             const int max_weight = 100,
+                             const RmatParams& params = {}) {
+  const int n = 1 << scale;
+  const std::size_t m = static_cast<std::size_t>(n) * edge_factor;
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  std::uniform_int_distribution<int> weight(1, max_weight);
+
+  std::vector<int> label(n);
+  std::iota(label.begin(), label.end(), 0);
+  std::shuffle(label.begin(), label.end(), rng);
+
+  std::vector<Edge> edges;
+  edges.reserve(m);
+  while (edges.size() < m) {
+    int v = 0;
+    int w = 0;
+    for (int bit = 0; bit < scale; ++bit) {
+      const double r = coin(rng);
+      // quadrants: a top left, b top right, c bottom left, d bottom right.
+      const bool right = (r >= params.a && r < params.a + params.b) ||
+                         r >= params.a + params.b + params.c;
+      const bool bottom = r >= params.a + params.b;
+      v = v << 1 | bottom;
+      w = w << 1 | right;
+    }
+    if (v != w) {
+      edges.push_back(
+          Edge{.v = label[v], .w = label[w], .weight = weight(rng)});
+    }
+  }
+  return edges;
+}
+
+// Erdos-Renyi G(n, m): m edges, each between two distinct vertices picked
+// uniformly at random, so the degrees are about Poisson with a mean of m / n
+// and there's no locality at all. multi-edges are kept.
+std::vector<Edge> erdos_renyi_edges(const int n, const std::size_t m,
+                                    const uint64_t seed = 1,
+                                    const int max_weight = 100) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> vertex(0, n - 1);
+  std::uniform_int_distribution<int> weight(1, max_weight);
+  std::vector<Edge> edges;
+  edges.reserve(m);
+  while (edges.size() < m) {
+    const int v = vertex(rng);
+    const int w = vertex(rng);
+    if (v != w) {
+      edges.push_back(Edge{.v = v, .w = w, .weight = weight(rng)});
+    }
+  }
+  return edges;
+}
+
+// a rows x cols grid, each vertex linked to its 4 neighbors by a road of the
+// same weight in both directions, like a road network: low degree, large
+// diameter. the id of the vertex at (r, c) is r * cols + c.
+std::vector<Edge> grid_edges(const int rows, const int cols,
+                             const uint64_t seed = 1,
+                             const int max_weight = 100) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> weight(1, max_weight);
+  std::vector<Edge> edges;
+  edges.reserve(4 * static_cast<std::size_t>(rows) * cols);
+  const auto road = [&](const int v, const int w) {
+    const int x = weight(rng);
+    edges.push_back(Edge{.v = v, .w = w, .weight = x});
+    edges.push_back(Edge{.v = w, .w = v, .weight = x});
+  };
+  for (int r = 0; r < rows; ++r) {
+    for (int c = 0; c < cols; ++c) {
+      const int v = r * cols + c;
+      if (c + 1 < cols) {
+        road(v, v + 1);
+      }
+      if (r + 1 < rows) {
+        road(v, v + cols);
+      }
+    }
+  }
+  return edges;
+}
+
+// the path 0 -> 1 -> ... -> n-1, the worst case of the depth of a DFS and
+// of the #levels of a BFS.
+std::vector<Edge> chain_edges(const int n, const uint64_t seed = 1,
+                              const int max_weight = 100) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> weight(1, max_weight);
+  std::vector<Edge> edges;
+  edges.reserve(std::max(0, n - 1));
+  for (int v = 0; v + 1 < n; ++v) {
+    edges.push_back(Edge{.v = v, .w = v + 1, .weight = weight(rng)});
+  }
+  return edges;
+}
+
+// the edges and their reverses, i.e. the directed form of the undirected
+// graph of the edges, for the algorithms on undirected graphs.
+std::vector<Edge> symmetrized(std::vector<Edge> edges) {
+  const std::size_t m = edges.size();
+  edges.reserve(2 * m);
+  for (std::size_t i = 0; i < m; ++i) {
+    edges.push_back(edges[i].reversed());
+  }
+  return edges;
+}
+
+#endif  // GENERATORS_HPP_
@@ -1,124 +1,421 @@
 #ifndef GRAPH_HPP_
 #define GRAPH_HPP_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory_resource>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "parallel.hpp"
+
 // note, a vertex may also has a corresponding key.
 // if it's such a case, just create a vertex type to wrap
 // the vertex id the vertex key.
 
+// the weight type of an unweighted graph. an edge stores no weight then,
+// since the member takes no space by [[no_unique_address]], and all weights
+// compare equal.
+struct NoWeight {
+  constexpr auto operator<=>(const NoWeight&) const = default;
+};
+
+// distance of an unreachable vertex for the weight type W.
+// do not use the max of an integer type to avoid integer overflow when
+// adding a weight. floating point weights have a true infinity.
+template <typename W>
+constexpr W max_dist = std::is_floating_point_v<W>
+                           ? std::numeric_limits<W>::infinity()
+                           : std::numeric_limits<W>::max() / 2;
+
+// the directedness of a BasicGraph, fixed at compile time.
+// Directed: add_edge adds v -> w only.
+// Undirected: add_edge adds both v -> w and w -> v.
+struct Directed {
+  static constexpr bool directed = true;
+};
+struct Undirected {
+  static constexpr bool directed = false;
+};
+
 // undirected/directed weighted edge.
 // although undirected edge has no concept of source and
 // destination vertices, it's more intuitive to set source
 // and destination vertices.
-struct Edge {
-  int v;  // source vertex id.
-  int w;  // destination vertex id.
-  int weight;
+/// @tparam VertexId an integer type, e.g. uint32_t to save memory or
+/// uint64_t for more than 4G vertices.
+/// @tparam Weight int, float, double, or NoWeight for an unweighted graph.
+template <typename VertexId, typename Weight>
+struct BasicEdge {
+  using vertex_type = VertexId;
+  using weight_type = Weight;
 
-  static Edge make(const int v, const int w, const int weight = 0) {
-    return Edge{.v = w, .w = v, .weight = weight};
+  VertexId v;  // source vertex id.
+  VertexId w;  // destination vertex id.
+  [[no_unique_address]] Weight weight{};
+
+  static BasicEdge make(const VertexId v, const VertexId w,
+                        const Weight weight = Weight{}) {
+    return BasicEdge{.v = v, .w = w, .weight = weight};
   }
 
   // construct an edge with the source and destination vertices reversed.
-  Edge reversed() const { return Edge{.v = w, .w = v, .weight = weight}; }
+  BasicEdge reversed() const {
+    return BasicEdge{.v = w, .w = v, .weight = weight};
+  }
 
   // return true if this edge is identical to the other edge.
-  bool equal(const Edge& other) const {
+  bool equal(const BasicEdge& other) const {
     return (v == other.v && w == other.w) || (w == other.v && v == other.w);
   }
 
+  // key identifying the undirected edge, i.e. v -> w and w -> v have the same
+  // key. it packs the (min, max) endpoints into 64 bits.
+  uint64_t key() const
+    requires(sizeof(VertexId) <= sizeof(uint32_t))
+  {
+    const auto [lo, hi] = std::minmax(v, w);
+    return (static_cast<uint64_t>(static_cast<uint32_t>(lo)) << 32) |
+           static_cast<uint32_t>(hi);
+  }
+
   // less comparator. Used to sort edges by non-decreasing weight.
-  static bool less(const Edge& a, const Edge& b) {
-    return a.weight <= b.weight;
+  // note, it must be strict, i.e. less(a, a) is false, as std::sort and
+  // std::list::sort require a strict weak ordering.
+  static bool less(const BasicEdge& a, const BasicEdge& b) {
+    return a.weight < b.weight;
   }
 
   // greater comparator. Used to construct a min-heap of edges.
   // note, the c++ priority queue lib requires you to feed into a greater comp
   // to construct a min-heap.
   struct greater {
-    bool operator()(const Edge& a, const Edge& b) {
-      return a.weight >= b.weight;
+    bool operator()(const BasicEdge& a, const BasicEdge& b) const {
+      return a.weight > b.weight;
     }
   };
 };
 
-std::list<Edge> dedup_edges(const std::list<Edge>& edges) {
-  std::list<Edge> es;
+// the edge type of the algorithms.
+using Edge = BasicEdge<int, int>;
+
+// which one of the duplicated edges is kept by dedup_edges.
+enum class DedupPolicy {
+  first,       // the first one in the input order.
+  min_weight,  // the one with the lowest weight, first one on ties.
+  max_weight,  // the one with the highest weight, first one on ties.
+};
+
+// return true if the duplicated edge e shall replace the kept edge per the
+// policy.
+bool dedup_prefers(const Edge& e, const Edge& kept, const DedupPolicy policy) {
+  switch (policy) {
+    case DedupPolicy::min_weight:
+      return e.weight < kept.weight;
+    case DedupPolicy::max_weight:
+      return e.weight > kept.weight;
+    default:
+      return false;
+  }
+}
+
+// remove duplicated undirected edges, i.e. v -> w and w -> v are identical.
+// this algo works as such: canonicalize each edge to its (min, max) endpoints
+// key and keep a hash table from the key to the slot of the kept edge in the
+// output. so it runs in expected O(E) instead of the O(E^2) pairwise check.
+// the kept edges are in the order of the first appearance of their keys.
+/// @param edges any iterable range of edges, e.g. Graph::all_edges() or
+/// CsrGraph::all_edges().
+template <typename Edges>
+std::list<Edge> dedup_edges(const Edges& edges,
+                            const DedupPolicy policy = DedupPolicy::first) {
+  std::vector<Edge> es;
+  // key: canonical key, value: slot of the kept edge in es.
+  std::unordered_map<uint64_t, std::size_t> slot_of;
   for (const Edge& e : edges) {
-    if (std::find_if(es.cbegin(), es.cend(), [=](const Edge& other) {
-          return e.equal(other);
-        }) != es.cend()) {
-      continue;
+    const auto [it, inserted] = slot_of.try_emplace(e.key(), es.size());
+    if (inserted) {
+      es.push_back(e);
+    } else if (dedup_prefers(e, es[it->second], policy)) {
+      es[it->second] = e;
     }
-    es.push_back(e);
   }
+  return std::list<Edge>(es.cbegin(), es.cend());
+}
+
+// parallel variant of dedup_edges with the same output.
+// this algo works as below:
+// (1) sort the (key, input position) pairs in parallel so that duplicated
+//     edges are adjacent.
+// (2) split the sorted pairs into chunks aligned to key groups, and each
+//     thread picks the kept edge of each group in its chunks per the policy.
+//     the kept edge takes the slot of the first appearance of its key.
+// (3) compact the kept edges in parallel in the input order.
+// note, the edges are returned in a vector since this variant targets large
+// edge sets.
+template <typename Edges>
+std::vector<Edge> parallel_dedup_edges(
+    const Edges& edges, const DedupPolicy policy = DedupPolicy::first,
+    const int num_threads = hardware_threads()) {
+  const std::vector<Edge> in(edges.begin(), edges.end());
+  const std::size_t n = in.size();
+
+  // {canonical key, input position}.
+  std::vector<std::pair<uint64_t, std::size_t>> keys(n);
+  parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+    for (std::size_t i = begin; i < end; ++i) {
+      keys[i] = {in[i].key(), i};
+    }
+  });
+  parallel_sort(keys.begin(), keys.end(), num_threads);
+
+  // keep[i] = 1 if the i-th input edge is the first appearance of its key.
+  // char instead of bool so that threads can write adjacent slots freely.
+  std::vector<char> keep(n, 0);
+  // pick[i] = input position of the kept edge of the key group whose first
+  // appearance is i. the kept edge takes the slot of the first appearance, the
+  // same as dedup_edges.
+  std::vector<std::size_t> pick(n);
+  parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+    // a key group belongs to the chunk containing its first pair.
+    while (begin > 0 && begin < n &&
+           keys[begin].first == keys[begin - 1].first) {
+      ++begin;
+    }
+    for (std::size_t i = begin; i < end;) {
+      // within a group, pairs are sorted by input position, so the first pair
+      // is the first appearance.
+      std::size_t kept = keys[i].second;
+      std::size_t j = i + 1;
+      for (; j < n && keys[j].first == keys[i].first; ++j) {
+        if (dedup_prefers(in[keys[j].second], in[kept], policy)) {
+          kept = keys[j].second;
+        }
+      }
+      keep[keys[i].second] = 1;
+      pick[keys[i].second] = kept;
+      i = j;
+    }
+  });
+
+  // #kept edges per chunk, turned into the output offset of each chunk.
+  const int chunks = std::max(1, num_threads);
+  const std::size_t chunk = (n + chunks - 1) / chunks;
+  std::vector<std::size_t> offset(chunks + 1, 0);
+  parallel_for(chunks, num_threads,
+               [&](std::size_t begin, std::size_t end, int) {
+                 for (std::size_t c = begin; c < end; ++c) {
+                   const std::size_t last = std::min(n, (c + 1) * chunk);
+                   for (std::size_t i = c * chunk; i < last; ++i) {
+                     offset[c + 1] += keep[i];
+                   }
+                 }
+               });
+  for (int c = 0; c < chunks; ++c) {
+    offset[c + 1] += offset[c];
+  }
+
+  std::vector<Edge> es(offset[chunks]);
+  parallel_for(chunks, num_threads,
+               [&](std::size_t begin, std::size_t end, int) {
+                 for (std::size_t c = begin; c < end; ++c) {
+                   std::size_t slot = offset[c];
+                   const std::size_t last = std::min(n, (c + 1) * chunk);
+                   for (std::size_t i = c * chunk; i < last; ++i) {
+                     if (keep[i]) {
+                       es[slot++] = in[pick[i]];
+                     }
+                   }
+                 }
+               });
   return es;
 }
 
-// undirected weighted graph represented as adjacency list.
+// a version never handed out before, for BasicGraph::version.
+uint64_t next_graph_version() {
+  static std::atomic<uint64_t> last{0};
+  return last.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// weighted graph represented as adjacency list.
 // note, for simplicity, there's no error handling.
-class Graph {
+//
+// the algorithms are written against the following neighbor-range interface,
+// which is shared by Graph and CsrGraph (see csr_graph.hpp):
+// - all_vertices(): an iterable range of all vertices.
+// - edges(v): an iterable range of the outgoing edges of the vertex v.
+// - all_edges(): an iterable range of all edges.
+// - reversed(): a graph of the same type with all edges reversed.
+//
+// the id and weight types and the directedness are template parameters, see
+// BasicEdge and Directed/Undirected. e.g. an unweighted graph with uint32_t
+// ids stores 8 bytes of edge per list node instead of 12.
+// note, the algorithms don't take all of them. they take Graph, i.e. int ids
+// and weights, and add_edge adds one direction only so that a Graph may be
+// used as either, by convention. the DFS based algorithms and CsrGraph also
+// take a BasicGraph with int ids and int or NoWeight weights, the latter
+// frozen with weight 1 per edge, i.e. the CSR arrays keep an int weight per
+// edge either way. the other instantiations, e.g. other id types or floating
+// point weights, are for storing graphs only, no algorithm accepts them yet.
+//
+// the list and map nodes are allocated from a std::pmr::memory_resource, the
+// default heap unless one is given. e.g. with a monotonic arena, building a
+// graph is a pointer bump per node, and the whole graph is released at once
+// with the arena:
+//
+//   std::pmr::monotonic_buffer_resource arena;
+//   Graph g(&arena);
+//
+// the arena must outlive the graph. a copy of a graph uses the default heap
+// again, same as the pmr containers.
+template <typename VertexId, typename Weight, typename Directedness>
+class BasicGraph {
  public:
-  Graph() = default;
-  explicit Graph(const std::list<int>& vertices) : vertices{vertices} {}
+  using vertex_type = VertexId;
+  using weight_type = Weight;
+  using edge_type = BasicEdge<VertexId, Weight>;
+  static constexpr bool directed = Directedness::directed;
+
+  BasicGraph() = default;
+  explicit BasicGraph(std::pmr::memory_resource* const resource)
+      : vertices(resource), vertex_set(resource), adj_list(resource) {}
+  explicit BasicGraph(const std::list<VertexId>& vertices,
+                      std::pmr::memory_resource* const resource =
+                          std::pmr::get_default_resource())
+      : BasicGraph(resource) {
+    for (const VertexId& v : vertices) {
+      maybe_add_vertex(v);
+    }
+  }
+
+  // construct a graph from any iterable range of vertices, e.g. the
+  // all_vertices() of another graph type.
+  // a pointer to a derived memory resource must not be taken as a range.
+  template <typename Vertices>
+    requires(!std::is_convertible_v<Vertices, std::pmr::memory_resource*>)
+  explicit BasicGraph(const Vertices& vertices,
+                      std::pmr::memory_resource* const resource =
+                          std::pmr::get_default_resource())
+      : BasicGraph(resource) {
+    for (const VertexId& v : vertices) {
+      maybe_add_vertex(v);
+    }
+  }
+
+  // an undirected graph converts to the directed graph holding both
+  // directions of each edge, e.g. Graph mst = kruskal_min_span_tree(g).
+  // a template, so that it's never taken as a copy constructor.
+  template <typename Other>
+    requires(directed && std::is_same_v<Other, Undirected>)
+  BasicGraph(const BasicGraph<VertexId, Weight, Other>& g)
+      : BasicGraph(g.all_vertices(), g.resource()) {
+    for (const edge_type& e : g.all_edges()) {
+      add_edge(e);
+    }
+  }
 
   // although add_edge may add vertices by the way, some vertices in a graph may
   // not have any connected edges, you have to call add_vertex to add each
   // vertex.
-  void add_vertex(const int& v) { maybe_add_vertex(v); }
+  void add_vertex(const VertexId& v) { maybe_add_vertex(v); }
 
-  // add a directed edge.
-  void add_edge(const Edge& e) {
+  // add a directed edge, or for an undirected graph also its reverse. a self
+  // loop of an undirected graph is added once.
+  void add_edge(const edge_type& e) {
     adj_list[e.v].push_back(e);
+    if constexpr (!directed) {
+      if (e.v != e.w) {
+        adj_list[e.w].push_back(e.reversed());
+      }
+    }
     maybe_add_vertex(e.v);
     maybe_add_vertex(e.w);
+    version_ = next_graph_version();
   }
 
-  std::list<int> all_vertices() const { return vertices; }
+  const std::pmr::list<VertexId>& all_vertices() const { return vertices; }
 
-  std::list<Edge> edges(const int v) const {
-    if (adj_list.count(v) == 0) {
-      return {};
+  // note, a reference is returned to avoid copying the edge list on every
+  // neighbor iteration.
+  const std::pmr::list<edge_type>& edges(const VertexId v) const {
+    static const std::pmr::list<edge_type> no_edges;
+    const auto it = adj_list.find(v);
+    if (it == adj_list.cend()) {
+      return no_edges;
     }
-    return adj_list.at(v);
+    return it->second;
   }
 
   // return all edges.
   // if this is a directed graph, all directed edges are returned.
   // if this is a undirected graph, all edges wherein the same edge is
   // duplicated once are returned.
-  std::list<Edge> all_edges() const {
-    std::list<Edge> edges;
+  std::list<edge_type> all_edges() const {
+    std::list<edge_type> edges;
     for (const auto& p : adj_list) {
       edges.insert(edges.end(), p.second.cbegin(), p.second.cend());
     }
     return edges;
   }
 
-  // create a graph with all directed egdes reversed.
-  Graph reversed() const {
-    Graph rg(vertices);
-    for (const int& v : vertices) {
-      for (const Edge& e : edges(v)) {
-        rg.add_edge(e.reversed());
+  // return each edge of an undirected graph once, as v <= w, i.e. without the
+  // reverse edges all_edges() duplicates.
+  std::list<edge_type> undirected_edges() const
+    requires(!directed)
+  {
+    std::list<edge_type> edges;
+    for (const auto& p : adj_list) {
+      for (const edge_type& e : p.second) {
+        if (e.v <= e.w) {
+          edges.push_back(e);
+        }
+      }
+    }
+    return edges;
+  }
+
+  // create a graph with all directed egdes reversed, on the same memory
+  // resource. an undirected graph is its own reverse.
+  BasicGraph reversed() const {
+    if constexpr (!directed) {
+      BasicGraph rg(resource());
+      rg = *this;
+      return rg;
+    } else {
+      BasicGraph rg(vertices, resource());
+      for (const VertexId& v : vertices) {
+        for (const edge_type& e : edges(v)) {
+          rg.add_edge(e.reversed());
+        }
       }
+      return rg;
     }
-    return rg;
   }
 
+  std::pmr::memory_resource* resource() const {
+    return vertices.get_allocator().resource();
+  }
+
+  // changes on each add_edge and each new vertex, to a value no graph had
+  // before, so that results cached for a version, e.g. by ShortestPathCache,
+  // are stale once it changes. a copy has the same version as long as it has
+  // the same vertices and edges. an empty graph has version 0.
+  uint64_t version() const { return version_; }
+
   // print the graph using adjacency list representation.
   void print() const {
-    std::vector<int> vs(vertices.cbegin(), vertices.cend());
+    std::vector<VertexId> vs(vertices.cbegin(), vertices.cend());
     std::sort(vs.begin(), vs.end());
-    for (const int& v : vs) {
+    for (const VertexId& v : vs) {
       std::cout << v << " -> ";
-      for (const Edge& e : edges(v)) {
+      for (const edge_type& e : edges(v)) {
         std::cout << e.w << ' ';
       }
       std::cout << '\n';
@@ -126,16 +423,30 @@ class Graph {
   }
 
  private:
-  // add the vertex v if it does exit.
-  void maybe_add_vertex(const int v) {
-    if (std::find(vertices.cbegin(), vertices.cend(), v) == vertices.cend()) {
+  // add the vertex v if it does not exist.
+  // the membership is checked against a hash set, so that building a graph
+  // with V vertices costs O(V) instead of O(V^2).
+  void maybe_add_vertex(const VertexId v) {
+    if (vertex_set.insert(v).second) {
       vertices.push_back(v);
+      version_ = next_graph_version();
     }
   }
 
-  std::list<int> vertices;
+  // vertices in the insertion order.
+  std::pmr::list<VertexId> vertices;
+  // the same vertices as above, used for O(1) membership check.
+  std::pmr::unordered_set<VertexId> vertex_set;
   // key: vertex, value: outgoing edges of this vertex.
-  std::map<int, std::list<Edge>> adj_list;
+  // the edge lists get the resource of the map by uses-allocator
+  // construction.
+  std::pmr::map<VertexId, std::pmr::list<edge_type>> adj_list;
+  uint64_t version_{0};
 };
 
+// the graph type of the algorithms.
+using Graph = BasicGraph<int, int, Directed>;
+// a Graph whose add_edge adds both directions.
+using UndirectedGraph = BasicGraph<int, int, Undirected>;
+
 #endif  //  GRAPH_HPP_
\ No newline at end of file
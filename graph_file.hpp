@@ -0,0 +1,352 @@
+#ifndef GRAPH_FILE_HPP_
+#define GRAPH_FILE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "csr_graph.hpp"
+
+// versioned binary graph file storing the CSR arrays of a CsrGraph.
+// the file is laid out as below, all integers in the native byte order:
+//   header | offsets (V + 1 int32) | targets (E int32) | weights (E int32) |
+//   ids (V int32)
+// each array starts at a 64-byte aligned position recorded in the header.
+// a file is loaded by memory-mapping it read-only and viewing the arrays in
+// place, so that opening a graph costs no parsing and no copying, and the
+// pages are shared between all processes mapping the same file.
+
+struct GraphFileHeader {
+  static constexpr char MAGIC[8] = {'C', 'S', 'R', 'G', 'R', 'A', 'P', 'H'};
+  static constexpr uint32_t VERSION = 1;
+  // written as is. a file written on a machine with the other byte order reads
+  // back a different value.
+  static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t endian_mark;
+  uint64_t num_vertices;
+  uint64_t num_edges;
+  // byte positions of the arrays from the start of the file.
+  uint64_t offsets_pos;
+  uint64_t targets_pos;
+  uint64_t weights_pos;
+  uint64_t ids_pos;
+
+  // fill in the array positions for a graph with V vertices and E edges.
+  /// @return the size of the file in bytes.
+  uint64_t layout(const uint64_t V, const uint64_t E) {
+    std::memcpy(magic, MAGIC, sizeof(magic));
+    version = VERSION;
+    endian_mark = ENDIAN_MARK;
+    num_vertices = V;
+    num_edges = E;
+    offsets_pos = align(sizeof(GraphFileHeader));
+    targets_pos = align(offsets_pos + (V + 1) * sizeof(int32_t));
+    weights_pos = align(targets_pos + E * sizeof(int32_t));
+    ids_pos = align(weights_pos + E * sizeof(int32_t));
+    return ids_pos + V * sizeof(int32_t);
+  }
+
+  // check the header against a file of the given size.
+  bool valid(const uint64_t file_size) const {
+    if (std::memcmp(magic, MAGIC, sizeof(magic)) != 0 || version != VERSION ||
+        endian_mark != ENDIAN_MARK) {
+      return false;
+    }
+    GraphFileHeader expected;
+    const uint64_t size = expected.layout(num_vertices, num_edges);
+    return size <= file_size && offsets_pos == expected.offsets_pos &&
+           targets_pos == expected.targets_pos &&
+           weights_pos == expected.weights_pos && ids_pos == expected.ids_pos;
+  }
+
+  static uint64_t align(const uint64_t pos) { return (pos + 63) / 64 * 64; }
+};
+
+// read-only or read-write memory mapping of a whole file.
+// the mapping is released on destruction.
+class MappedFile {
+ public:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+  }
+
+  // map an existing file read-only.
+  /// @return nullptr on failure.
+  static std::shared_ptr<MappedFile> open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return nullptr;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor.
+    close(fd);
+    if (data == MAP_FAILED) {
+      return nullptr;
+    }
+    return std::shared_ptr<MappedFile>(new MappedFile(data, st.st_size));
+  }
+
+  // create or truncate a file of the given size and map it read-write.
+  /// @return nullptr on failure.
+  static std::shared_ptr<MappedFile> create(const std::string& path,
+                                            const std::size_t size) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return nullptr;
+    }
+    if (ftruncate(fd, size) != 0) {
+      close(fd);
+      return nullptr;
+    }
+    void* data =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      return nullptr;
+    }
+    return std::shared_ptr<MappedFile>(new MappedFile(data, size));
+  }
+
+  char* data() const { return static_cast<char*>(data_); }
+  std::size_t size() const { return size_; }
+
+ private:
+  MappedFile(void* data, const std::size_t size) : data_{data}, size_{size} {}
+
+  void* data_;
+  std::size_t size_;
+};
+
+// write the graph as a binary graph file.
+/// @return false if the file cannot be written.
+bool save_csr_graph(const CsrGraph& g, const std::string& path) {
+  GraphFileHeader header;
+  const uint64_t size = header.layout(g.num_vertices(), g.num_edges());
+  const std::shared_ptr<MappedFile> file = MappedFile::create(path, size);
+  if (file == nullptr) {
+    return false;
+  }
+  // the file is zero-filled by ftruncate, so the padding needs no writes.
+  std::memcpy(file->data(), &header, sizeof(header));
+  const auto copy = [&](const uint64_t pos, const std::span<const int> a) {
+    std::copy(a.begin(), a.end(), reinterpret_cast<int*>(file->data() + pos));
+  };
+  copy(header.offsets_pos, g.offsets());
+  copy(header.targets_pos, g.targets());
+  copy(header.weights_pos, g.weights());
+  copy(header.ids_pos, g.ids());
+  return msync(file->data(), file->size(), MS_SYNC) == 0;
+}
+
+// open a binary graph file as a CsrGraph viewing the mapped arrays.
+// the mapping lives as long as the graph or any copy of it.
+/// @return false if the file cannot be mapped or is not a valid graph file.
+bool map_csr_graph(const std::string& path, CsrGraph& g) {
+  const std::shared_ptr<MappedFile> file = MappedFile::open(path);
+  if (file == nullptr || file->size() < sizeof(GraphFileHeader)) {
+    return false;
+  }
+  GraphFileHeader header;
+  std::memcpy(&header, file->data(), sizeof(header));
+  if (!header.valid(file->size())) {
+    return false;
+  }
+
+  const auto array = [&](const uint64_t pos, const uint64_t n) {
+    return std::span<const int>(
+        reinterpret_cast<const int*>(file->data() + pos), n);
+  };
+  g = CsrGraph::view(file, array(header.offsets_pos, header.num_vertices + 1),
+                     array(header.targets_pos, header.num_edges),
+                     array(header.weights_pos, header.num_edges),
+                     array(header.ids_pos, header.num_vertices));
+  return true;
+}
+
+// formats of the text graph files accepted by the converter.
+enum class TextFormat {
+  // one "v w [weight]" per line. lines starting with '#' or '%' are comments.
+  edge_list,
+  // SNAP, e.g. "v\tw" per line and '#' comments. same as the edge list.
+  snap,
+  // DIMACS shortest path, i.e. "p sp V E" once and then "a v w weight" per
+  // edge, 'c' comments. vertices are 1..V.
+  dimacs,
+};
+
+// streaming parser of a text graph file.
+// each edge is handed to the callback as soon as its line is parsed, so no
+// Graph is built in memory. an edge without a weight gets the weight 1, i.e.
+// the unweighted graph convention.
+// for DIMACS, the #vertices declared by the "p" line is reported through
+// on_num_vertices before any edge.
+/// @return false if the file cannot be read or has a malformed line.
+template <typename OnEdge, typename OnNumVertices>
+bool parse_text_graph(const std::string& path, const TextFormat format,
+                      OnEdge&& on_edge, OnNumVertices&& on_num_vertices) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(in, line)) {
+    const char* p = line.c_str();
+    while (*p == ' ' || *p == '\t') {
+      ++p;
+    }
+    if (*p == '\0' || *p == '\r') {
+      continue;
+    }
+
+    if (format == TextFormat::dimacs) {
+      if (*p == 'c') {
+        continue;
+      }
+      if (*p == 'p') {
+        // "p sp V E".
+        p = std::strchr(p, ' ');
+        p = p == nullptr ? nullptr : std::strchr(p + 1, ' ');
+        if (p == nullptr) {
+          return false;
+        }
+        on_num_vertices(std::strtol(p, nullptr, 10));
+        continue;
+      }
+      if (*p != 'a') {
+        return false;
+      }
+      ++p;
+    } else if (*p == '#' || *p == '%') {
+      continue;
+    }
+
+    char* end;
+    const long v = std::strtol(p, &end, 10);
+    if (end == p) {
+      return false;
+    }
+    p = end;
+    const long w = std::strtol(p, &end, 10);
+    if (end == p) {
+      return false;
+    }
+    p = end;
+    long weight = std::strtol(p, &end, 10);
+    if (end == p) {
+      weight = 1;
+    }
+    on_edge(Edge{.v = static_cast<int>(v),
+                 .w = static_cast<int>(w),
+                 .weight = static_cast<int>(weight)});
+  }
+  return !in.bad();
+}
+
+// convert a text graph file to a binary graph file without building a Graph.
+// this algo works as below:
+// (1) first pass: parse the text file to collect the vertex ids and count the
+//     outgoing edges of each vertex.
+// (2) lay out the binary file and fill in the offsets and the ids.
+// (3) second pass: parse the text file again and place each edge directly in
+//     the mapped targets and weights arrays.
+// so besides the output mapping, the memory use is O(V).
+/// @param symmetrize if true, also add the reversed edge of each non-loop
+/// edge, e.g. for SNAP undirected graphs that list each edge once.
+/// @return false if the input cannot be parsed or the output cannot be
+/// written.
+bool convert_text_graph(const std::string& text_path, const TextFormat format,
+                        const std::string& out_path,
+                        const bool symmetrize = false) {
+  // key: original vertex id, value: #outgoing edges, later the dense index.
+  std::unordered_map<int, int> degree;
+  long dimacs_num_vertices = 0;
+  uint64_t num_edges = 0;
+  const auto count = [&](const Edge& e) {
+    ++degree[e.v];
+    degree.try_emplace(e.w, 0);
+    ++num_edges;
+    if (symmetrize && e.v != e.w) {
+      ++degree[e.w];
+      ++num_edges;
+    }
+  };
+  if (!parse_text_graph(text_path, format, count,
+                        [&](const long n) { dimacs_num_vertices = n; })) {
+    return false;
+  }
+  for (int v = 1; v <= dimacs_num_vertices; ++v) {
+    degree.try_emplace(v, 0);
+  }
+
+  std::vector<int> ids;
+  ids.reserve(degree.size());
+  for (const auto& p : degree) {
+    ids.push_back(p.first);
+  }
+  std::sort(ids.begin(), ids.end());
+  const uint64_t V = ids.size();
+
+  GraphFileHeader header;
+  const uint64_t size = header.layout(V, num_edges);
+  const std::shared_ptr<MappedFile> file = MappedFile::create(out_path, size);
+  if (file == nullptr) {
+    return false;
+  }
+  std::memcpy(file->data(), &header, sizeof(header));
+  int* offsets = reinterpret_cast<int*>(file->data() + header.offsets_pos);
+  int* targets = reinterpret_cast<int*>(file->data() + header.targets_pos);
+  int* weights = reinterpret_cast<int*>(file->data() + header.weights_pos);
+  std::copy(ids.cbegin(), ids.cend(),
+            reinterpret_cast<int*>(file->data() + header.ids_pos));
+
+  // next[v] = the next free edge slot of the vertex v.
+  std::vector<int> next(V);
+  offsets[0] = 0;
+  for (uint64_t v = 0; v < V; ++v) {
+    next[v] = offsets[v];
+    offsets[v + 1] = offsets[v] + degree[ids[v]];
+    degree[ids[v]] = v;
+  }
+
+  const auto place = [&](const Edge& e) {
+    const int v = degree[e.v];
+    const int w = degree[e.w];
+    targets[next[v]] = w;
+    weights[next[v]++] = e.weight;
+    if (symmetrize && v != w) {
+      targets[next[w]] = v;
+      weights[next[w]++] = e.weight;
+    }
+  };
+  if (!parse_text_graph(text_path, format, place, [](long) {})) {
+    return false;
+  }
+  return msync(file->data(), file->size(), MS_SYNC) == 0;
+}
+
+#endif  // GRAPH_FILE_HPP_
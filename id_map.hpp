@@ -0,0 +1,68 @@
+#ifndef ID_MAP_HPP_
+#define ID_MAP_HPP_
+
+#include <cassert>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// interning layer mapping arbitrary external vertex keys, e.g. sparse int ids
+// or strings, to dense internal indices 0..N-1 in the order of first sight.
+// build a graph on the dense indices and any per-vertex state downstream can
+// be kept in a flat vector instead of an unordered_map:
+//
+//   IdMap<std::string> ids;
+//   Graph g;
+//   g.add_edge(Edge{.v = ids.intern("a"), .w = ids.intern("b"), .weight = 1});
+//   std::vector<int> dist(ids.size());
+//
+// the key of a dense index is recovered by key().
+template <typename Key, typename Hash = std::hash<Key>>
+class IdMap {
+ public:
+  IdMap() = default;
+
+  // pre-allocate for n keys to avoid rehashing during a bulk load.
+  void reserve(const int n) {
+    index_of.reserve(n);
+    keys_.reserve(n);
+  }
+
+  // return the dense index of the key, assigning the next free index if the
+  // key is seen for the first time.
+  int intern(const Key& key) {
+    const auto [it, inserted] =
+        index_of.try_emplace(key, static_cast<int>(keys_.size()));
+    if (inserted) {
+      keys_.push_back(key);
+    }
+    return it->second;
+  }
+
+  /// @return -1 if the key is not interned.
+  int index(const Key& key) const {
+    const auto it = index_of.find(key);
+    return it == index_of.cend() ? -1 : it->second;
+  }
+
+  bool contains(const Key& key) const { return index_of.count(key) > 0; }
+
+  // the key of the dense index v.
+  const Key& key(const int v) const {
+    assert(v >= 0 && v < size());
+    return keys_[v];
+  }
+
+  // key: dense index, value: external key.
+  const std::vector<Key>& keys() const { return keys_; }
+
+  int size() const { return static_cast<int>(keys_.size()); }
+
+ private:
+  // key: external key, value: dense index.
+  std::unordered_map<Key, int, Hash> index_of;
+  // key: dense index, value: external key.
+  std::vector<Key> keys_;
+};
+
+#endif  // ID_MAP_HPP_
@@ -0,0 +1,123 @@
+#ifndef INDEXED_HEAP_HPP_
+#define INDEXED_HEAP_HPP_
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+// indexed d-ary min-heap over dense item ids 0..N-1 with decrease-key.
+// compared to std::priority_queue, each item is in the heap at most once, so
+// a relaxation lowers the key in place instead of pushing a duplicate, and no
+// stale entries are ever popped.
+// pos[v] tracks the slot of the item v so that it can be found in O(1). a
+// larger arity D makes the heap shallower, which trades a few more key
+// comparisons in pop for less work in decrease-key, the more frequent one in
+// shortest path searches. the keys are stored inline with the items so that
+// sifting touches one array only.
+template <typename Key = int, int D = 4>
+class IndexedHeap {
+ public:
+  IndexedHeap() = default;
+  explicit IndexedHeap(const int n) : pos(n, -1) {}
+
+  // allow item ids 0..n-1. the heap must be empty.
+  void resize(const int n) {
+    assert(heap.empty());
+    pos.assign(n, -1);
+  }
+
+  bool empty() const { return heap.empty(); }
+  int size() const { return static_cast<int>(heap.size()); }
+  bool contains(const int v) const { return pos[v] >= 0; }
+
+  // the item with the lowest key and its key.
+  int top() const { return heap.front().second; }
+  const Key& top_key() const { return heap.front().first; }
+
+  // insert the item v with the key, or lower its key if v is in the heap
+  // with a higher key.
+  void push_or_decrease(const int v, const Key& key) {
+    if (pos[v] < 0) {
+      pos[v] = size();
+      heap.emplace_back(key, v);
+    } else if (key < heap[pos[v]].first) {
+      heap[pos[v]].first = key;
+    } else {
+      return;
+    }
+    sift_up(pos[v]);
+  }
+
+  // remove and return the item with the lowest key.
+  int pop() {
+    const int v = heap.front().second;
+    pos[v] = -1;
+    if (size() > 1) {
+      heap.front() = heap.back();
+      pos[heap.front().second] = 0;
+      heap.pop_back();
+      sift_down(0);
+    } else {
+      heap.pop_back();
+    }
+    return v;
+  }
+
+  // remove all items in O(size), not O(N).
+  void clear() {
+    for (const auto& [key, v] : heap) {
+      pos[v] = -1;
+    }
+    heap.clear();
+  }
+
+ private:
+  void sift_up(int i) {
+    const std::pair<Key, int> item = heap[i];
+    while (i > 0) {
+      const int parent = (i - 1) / D;
+      if (!(item.first < heap[parent].first)) {
+        break;
+      }
+      place(i, heap[parent]);
+      i = parent;
+    }
+    place(i, item);
+  }
+
+  void sift_down(int i) {
+    const std::pair<Key, int> item = heap[i];
+    const int n = size();
+    while (true) {
+      const int first = D * i + 1;
+      if (first >= n) {
+        break;
+      }
+      const int last = first + D < n ? first + D : n;
+      int best = first;
+      for (int c = first + 1; c < last; ++c) {
+        if (heap[c].first < heap[best].first) {
+          best = c;
+        }
+      }
+      if (!(heap[best].first < item.first)) {
+        break;
+      }
+      place(i, heap[best]);
+      i = best;
+    }
+    place(i, item);
+  }
+
+  void place(const int i, const std::pair<Key, int>& item) {
+    heap[i] = item;
+    pos[item.second] = i;
+  }
+
+  // {key, item}.
+  std::vector<std::pair<Key, int>> heap;
+  // key: item, value: slot in the heap, or -1 if not in the heap.
+  std::vector<int> pos;
+};
+
+#endif  // INDEXED_HEAP_HPP_
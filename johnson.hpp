@@ -0,0 +1,95 @@
+#ifndef JOHNSON_HPP_
+#define JOHNSON_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "bellman_ford.hpp"
+#include "csr_graph.hpp"
+#include "dijkstra_engine.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+
+// Johnson's algorithm for all pairs shortest paths on a sparse graph with
+// negative-weight edges.
+// this algo works as below:
+// (1) run one Bellman-Ford from a virtual source with a zero-weight edge to
+//     each vertex. its distances h(v) are the potentials.
+// (2) reweight each edge v -> w to weight + h(v) - h(w), which is
+//     non-negative since h(w) <= h(v) + weight.
+// (3) run Dijkstra from each vertex on the reweighted graph. the reweighting
+//     adds h(src) - h(dst) to every src -> dst path alike, so the shortest
+//     paths stay the same, and the distance is
+//     dist'(src, dst) - h(src) + h(dst).
+//
+// intuition: O(V * E log V) instead of O(V^3), which wins as long as E is far
+// below V^2. and each Dijkstra is independent of the others, so the sources
+// are spread over the threads, each with its own DijkstraEngine.
+//
+// the rows are streamed to the caller one source at a time so that the V^2
+// matrix is never held in memory.
+/// @param on_row on_row(src, dist, parent) is called once per source with the
+/// distances from src, MAX_DIST if unreachable, and the parents of the
+/// shortest path tree, both indexed by the dense vertex index. it's called
+/// concurrently from the worker threads in no particular order, and the spans
+/// are only valid during the call.
+/// @return false if there's a negative cycle, in which case no row is
+/// streamed.
+template <typename OnRow>
+bool johnson_apsp(const CsrGraph& g, OnRow&& on_row,
+                  const int num_threads = hardware_threads()) {
+  const int n = g.num_vertices();
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> weights = g.weights();
+
+  // the potentials, all 0 if there's no negative weight.
+  std::vector<int> h(n, 0);
+  CsrGraph rg = g;
+  if (std::any_of(weights.begin(), weights.end(),
+                  [](const int w) { return w < 0; })) {
+    BellmanFordResult potentials = spfa(g, -1);
+    if (!potentials.negative_cycle.empty()) {
+      return false;
+    }
+    h = std::move(potentials.tree.dist);
+
+    // the reweighted graph shares the offsets/targets/ids of g.
+    struct Reweighted {
+      CsrGraph base;
+      std::vector<int> weights;
+    };
+    auto storage = std::make_shared<Reweighted>();
+    storage->base = g;
+    storage->weights.resize(weights.size());
+    for (int v = 0; v < n; ++v) {
+      for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+        storage->weights[i] = weights[i] + h[v] - h[targets[i]];
+      }
+    }
+    const std::span<const int> new_weights = storage->weights;
+    rg = CsrGraph::view(storage, offsets, targets, new_weights, g.ids());
+  }
+
+  parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+    DijkstraEngine engine(rg);
+    std::vector<int> dist(n);
+    std::vector<int> parent(n);
+    for (std::size_t s = begin; s < end; ++s) {
+      const int src = static_cast<int>(s);
+      engine.run(src);
+      for (int v = 0; v < n; ++v) {
+        const int d = engine.dist(v);
+        dist[v] = d == MAX_DIST ? MAX_DIST : d - h[src] + h[v];
+        parent[v] = engine.parent(v);
+      }
+      on_row(src, std::span<const int>(dist), std::span<const int>(parent));
+    }
+  });
+  return true;
+}
+
+#endif  // JOHNSON_HPP_
@@ -1,12 +1,22 @@
 #ifndef MINIMUM_SPANNING_TREE_HPP_
 #define MINIMUM_SPANNING_TREE_HPP_
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <queue>
+#include <span>
 #include <unordered_set>
+#include <vector>
 
+#include "csr_graph.hpp"
 #include "graph.hpp"
+#include "parallel.hpp"
 #include "union_find.hpp"
+#include "workspace.hpp"
 
 // kruskal minimum spanning tree algorithm.
 // this algorithm works as below:
@@ -15,16 +25,22 @@
 // (2.a) if adding this edge won't form a loop in the mst, add it.
 // (2.b) otherwise, discard it.
 // (3) after examined all edges, the mst is constructed.
+//
+// see filter_kruskal_mst and parallel_boruvka_mst below for the parallel
+// variants on edge vectors, which return the tree edges only.
 /// @param g connected graph, i.e. all vertices must be connected.
 /// @return the minimum spanning tree of the graph g.
-Graph kruskal_min_span_tree(const Graph& g) {
-  std::list<Edge> all_edges = dedup_edges(g.all_edges());
+template <typename G>
+UndirectedGraph kruskal_min_span_tree(const G& g) {
+  // of parallel edges, only the lightest can be in the mst.
+  std::list<Edge> all_edges =
+      dedup_edges(g.all_edges(), DedupPolicy::min_weight);
   all_edges.sort(Edge::less);
 
   // helper union-find data structure to detect loops.
-  UF uf(g.all_vertices());
+  auto uf = make_uf(g);
 
-  Graph mst(g.all_vertices());
+  UndirectedGraph mst(g.all_vertices());
 
   for (const Edge& e : all_edges) {
     // if v and w is already connected which says there's a path linking v and
@@ -32,7 +48,6 @@ Graph kruskal_min_span_tree(const Graph& g) {
     // and hence violates tree properties.
     if (!uf.is_connected(e.v, e.w)) {
       mst.add_edge(e);
-      mst.add_edge(e.reversed());
       uf.union_vertices(e.v, e.w);
     }
   }
@@ -41,14 +56,16 @@ Graph kruskal_min_span_tree(const Graph& g) {
 }
 
 // kruskal maximum spanning tree algorithm.
-Graph kruskal_max_span_tree(const Graph& g) {
-  std::list<Edge> all_edges = dedup_edges(g.all_edges());
+template <typename G>
+UndirectedGraph kruskal_max_span_tree(const G& g) {
+  std::list<Edge> all_edges =
+      dedup_edges(g.all_edges(), DedupPolicy::max_weight);
   all_edges.sort(Edge::greater());
 
   // helper union-find data structure to detect loops.
-  UF uf(g.all_vertices());
+  auto uf = make_uf(g);
 
-  Graph mst(g.all_vertices());
+  UndirectedGraph mst(g.all_vertices());
 
   for (const Edge& e : all_edges) {
     // if v and w is already connected which says there's a path linking v and
@@ -56,7 +73,6 @@ Graph kruskal_max_span_tree(const Graph& g) {
     // and hence violates tree properties.
     if (!uf.is_connected(e.v, e.w)) {
       mst.add_edge(e);
-      mst.add_edge(e.reversed());
       uf.union_vertices(e.v, e.w);
     }
   }
@@ -74,23 +90,28 @@ Graph kruskal_max_span_tree(const Graph& g) {
 //     queue. If the outgoing vertex of the edge is not in the mst currently,
 //     add all connected edges of the outgoing vertex into the queue. This edge
 //     is added into the mst.
+// the queue and the visited set are allocated from the workspace, only the
+// returned tree is on the heap.
 /// @param g connected graph, i.e. all vertices must be connected.
 /// @return the minimum spanning tree of the graph g.
-Graph prim_min_span_tree(const Graph& g) {
-  const std::list<int> vertices = g.all_vertices();
+template <typename G>
+UndirectedGraph prim_min_span_tree(
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const auto& vertices = g.all_vertices();
   assert(!vertices.empty());
   const int src = vertices.front();
 
-  std::priority_queue<Edge, std::vector<Edge>, Edge::greater> pq;
+  std::priority_queue<Edge, std::pmr::vector<Edge>, Edge::greater> pq(
+      Edge::greater(), std::pmr::vector<Edge>(ws.resource()));
   for (const Edge& e : g.edges(src)) {
     pq.push(e);
   }
 
   // helper hash set to contain visited vertices.
-  std::unordered_set<int> visited;
+  std::pmr::unordered_set<int> visited(ws.resource());
   visited.insert(src);
 
-  Graph mst(g.all_vertices());
+  UndirectedGraph mst(g.all_vertices());
 
   while (!pq.empty()) {
     const Edge e = pq.top();
@@ -103,7 +124,6 @@ Graph prim_min_span_tree(const Graph& g) {
     // edge which introduces a loop and hence cannot be added.
     if (visited.count(e.w) == 0) {
       mst.add_edge(e);
-      mst.add_edge(e.reversed());
       visited.insert(e.w);
       // push new edges into the queue.
       for (const Edge& ne : g.edges(e.w)) {
@@ -115,4 +135,226 @@ Graph prim_min_span_tree(const Graph& g) {
   return mst;
 }
 
+// MST as a compact edge vector, for graphs too large to copy into a Graph.
+struct MstResult {
+  // the tree edges, or the edges of a spanning forest if the graph is not
+  // connected.
+  std::vector<Edge> edges;
+  long long total_weight{0};
+};
+
+// the undirected edges of g, which holds both directions of each edge, as
+// the Graph based algos above expect. each edge is listed once, as v < w in
+// dense indices, and self loops are dropped.
+std::vector<Edge> undirected_edge_list(const CsrGraph& g) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> weights = g.weights();
+  std::vector<Edge> edges;
+  for (int v = 0; v < g.num_vertices(); ++v) {
+    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+      if (v < targets[i]) {
+        edges.push_back(Edge{.v = v, .w = targets[i], .weight = weights[i]});
+      }
+    }
+  }
+  return edges;
+}
+
+// Filter-Kruskal, after Osipov, Sanders and Singler.
+// this algo works as below:
+// (1) if there are few edges, run Kruskal on them: sort and scan.
+// (2) otherwise, partition the edges by a pivot weight into the light and
+//     heavy halves, and recurse on the light half first.
+// (3) before recursing on the heavy half, filter out the edges whose
+//     endpoints the light half already connected.
+//
+// intuition: on most graphs, the MST is found among the light edges and the
+// heavy ones are filtered rather than sorted, so the O(E log E) sort becomes
+// about O(E + V log V log(E / V)). the partitions, filters and base case
+// sorts run in parallel, and a filter only reads the union-find, which is
+// the lock-free ConcurrentUF.
+/// @param edges undirected edges of dense endpoints 0..num_vertices-1, e.g.
+/// from undirected_edge_list.
+MstResult filter_kruskal_mst(std::vector<Edge> edges, const int num_vertices,
+                             const int num_threads = hardware_threads()) {
+  // below this size, sort and scan.
+  constexpr std::size_t BASE = 1 << 16;
+  // #edges sampled to pick the pivot.
+  constexpr std::size_t SAMPLE = 63;
+
+  ConcurrentUF uf(num_vertices);
+  MstResult mst;
+  std::vector<Edge> scratch(edges.size());
+  const auto done = [&] {
+    return static_cast<int>(mst.edges.size()) >= num_vertices - 1;
+  };
+  const auto kruskal = [&](const std::span<Edge> e) {
+    parallel_sort(e.begin(), e.end(), Edge::less, num_threads);
+    for (const Edge& x : e) {
+      if (done()) {
+        return;
+      }
+      if (uf.union_vertices(x.v, x.w)) {
+        mst.edges.push_back(x);
+        mst.total_weight += x.weight;
+      }
+    }
+  };
+
+  // e holds the edges and scratch is free space of the same size.
+  const auto filter_kruskal = [&](auto& self, const std::span<Edge> e,
+                                  const std::span<Edge> scratch) -> void {
+    if (done() || e.empty()) {
+      return;
+    }
+    if (e.size() <= BASE) {
+      kruskal(e);
+      return;
+    }
+    std::vector<int> sample;
+    for (std::size_t i = 0; i < SAMPLE; ++i) {
+      sample.push_back(e[i * (e.size() - 1) / (SAMPLE - 1)].weight);
+    }
+    std::nth_element(sample.begin(), sample.begin() + SAMPLE / 2,
+                     sample.end());
+    const int pivot = sample[SAMPLE / 2];
+
+    const std::size_t num_light = parallel_partition<Edge>(
+        e, scratch, [&](const Edge& x) { return x.weight <= pivot; },
+        num_threads);
+    if (num_light == e.size()) {
+      // the pivot is the max weight, partitioning makes no progress.
+      kruskal(e);
+      return;
+    }
+    // the halves are in scratch now, and e is the free space.
+    self(self, scratch.first(num_light), e.first(num_light));
+
+    const std::span<Edge> heavy = scratch.subspan(num_light);
+    const std::span<Edge> kept = e.subspan(num_light);
+    const std::size_t num_kept = parallel_partition<Edge>(
+        heavy, kept,
+        [&](const Edge& x) { return uf.find(x.v) != uf.find(x.w); },
+        num_threads);
+    self(self, kept.first(num_kept), heavy.first(num_kept));
+  };
+  filter_kruskal(filter_kruskal, std::span<Edge>(edges),
+                 std::span<Edge>(scratch));
+  return mst;
+}
+
+// parallel Boruvka.
+// this algo works as below, in rounds until no edge joins two components:
+// (1) each edge offers itself to the components of both its endpoints, and
+//     each component keeps the lightest edge offered, by an atomic min.
+// (2) add the lightest edge of each component, uniting the two components.
+// (3) drop the edges within a component.
+// ties are broken by the edge index, so the edges picked in a round never
+// form a cycle. each round at least halves #components, so there're at most
+// log V rounds of O(E) parallel work. the endpoints of the remaining edges
+// are relabeled by their roots once per round, so the rest of the round
+// works on the contracted graph without any find.
+/// @param edges undirected edges of dense endpoints 0..num_vertices-1, at
+/// most 2^32 of them.
+MstResult parallel_boruvka_mst(const std::vector<Edge>& edges,
+                               const int num_vertices,
+                               const int num_threads = hardware_threads()) {
+  // {weight, index} packed so that the numeric order is the tie-broken
+  // weight order. flipping the sign bit orders negative weights first.
+  const auto pack = [](const Edge& e, const std::size_t i) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(e.weight) ^
+                                 0x80000000u)
+               << 32 |
+           static_cast<uint32_t>(i);
+  };
+  constexpr uint64_t NONE = ~uint64_t{0};
+
+  ConcurrentUF uf(num_vertices);
+  // key: component root, value: the packed lightest edge offered.
+  const auto lightest =
+      std::make_unique<std::atomic<uint64_t>[]>(num_vertices);
+  for (int v = 0; v < num_vertices; ++v) {
+    lightest[v].store(NONE, std::memory_order_relaxed);
+  }
+  const auto offer = [&](const int root, const uint64_t key) {
+    uint64_t old = lightest[root].load(std::memory_order_relaxed);
+    while (key < old && !lightest[root].compare_exchange_weak(
+                            old, key, std::memory_order_relaxed)) {
+    }
+  };
+
+  // an edge between the components of v and w. v and w are the roots at the
+  // start of the round, so that offering needs no find.
+  struct Arc {
+    int v;
+    int w;
+    uint32_t edge;
+  };
+  std::vector<Arc> arcs(edges.size());
+  std::vector<Arc> scratch(edges.size());
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    arcs[i] = Arc{.v = edges[i].v,
+                  .w = edges[i].w,
+                  .edge = static_cast<uint32_t>(i)};
+  }
+  std::span<Arc> alive(arcs);
+  std::span<Arc> spare(scratch);
+  // per-thread tree edges.
+  std::vector<std::vector<Edge>> picked(std::max(1, num_threads));
+  while (true) {
+    parallel_for(alive.size(), num_threads,
+                 [&](std::size_t begin, std::size_t end, int) {
+                   for (std::size_t i = begin; i < end; ++i) {
+                     alive[i].v = uf.find(alive[i].v);
+                     alive[i].w = uf.find(alive[i].w);
+                   }
+                 });
+    const std::size_t num_alive = parallel_partition<Arc>(
+        alive, spare, [](const Arc& a) { return a.v != a.w; }, num_threads);
+    std::swap(alive, spare);
+    alive = alive.first(num_alive);
+    spare = spare.first(num_alive);
+    if (num_alive == 0) {
+      break;
+    }
+
+    parallel_for(num_alive, num_threads,
+                 [&](std::size_t begin, std::size_t end, int) {
+                   for (std::size_t i = begin; i < end; ++i) {
+                     const Arc& a = alive[i];
+                     const uint64_t key = pack(edges[a.edge], a.edge);
+                     offer(a.v, key);
+                     offer(a.w, key);
+                   }
+                 });
+    // only roots have an offer. an edge picked by both its components is
+    // united once, the second union finds them connected.
+    parallel_for(num_vertices, num_threads,
+                 [&](std::size_t begin, std::size_t end, const int t) {
+                   for (std::size_t v = begin; v < end; ++v) {
+                     const uint64_t key =
+                         lightest[v].load(std::memory_order_relaxed);
+                     if (key == NONE) {
+                       continue;
+                     }
+                     lightest[v].store(NONE, std::memory_order_relaxed);
+                     const Edge& e = edges[static_cast<uint32_t>(key)];
+                     if (uf.union_vertices(e.v, e.w)) {
+                       picked[t].push_back(e);
+                     }
+                   }
+                 });
+  }
+
+  MstResult mst;
+  for (const std::vector<Edge>& p : picked) {
+    for (const Edge& e : p) {
+      mst.edges.push_back(e);
+      mst.total_weight += e.weight;
+    }
+  }
+  return mst;
+}
+
 #endif  // MINIMUM_SPANNING_TREE_HPP_
\ No newline at end of file
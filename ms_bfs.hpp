@@ -0,0 +1,201 @@
+#ifndef MS_BFS_HPP_
+#define MS_BFS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+
+// multi-source BFS (MS-BFS), after Then et al.
+// hop distances from a batch of up to 64 * K sources in one traversal. each
+// vertex keeps a bitset with one bit per search of the batch:
+// - seen[v]: the searches which have reached v.
+// - visit[v]: the searches for which v is on the current frontier.
+// and each level is one pass over the graph:
+//   next[w] = OR of visit[u] over the in-neighbors u of w, minus seen[w].
+// the bits set in next[w] are the searches reaching w on this level.
+//
+// intuition: searches from nearby sources over the same graph mostly scan the
+// same edges in the same levels. one scan of an edge now serves the whole
+// batch by a word OR, instead of once per search.
+//
+// it pulls from the in-neighbors, so each thread only writes the vertices of
+// its own chunk, and vertices already seen by all searches are skipped.
+// K > 1 packs 64 * K searches into std::array words, whose ORs the compiler
+// vectorizes, e.g. into one AVX2 op for K = 4.
+template <int K = 1>
+class MultiSourceBfs {
+ public:
+  static constexpr int BATCH = 64 * K;
+
+  explicit MultiSourceBfs(const CsrGraph& g,
+                          const int num_threads = hardware_threads())
+      : MultiSourceBfs(g, g.reversed(), num_threads) {}
+  /// @param rg g.reversed(), passed in if the caller already has it, or g
+  /// itself if g is undirected.
+  MultiSourceBfs(const CsrGraph& g, const CsrGraph& rg,
+                 const int num_threads = hardware_threads())
+      : g{g},
+        rg{rg},
+        n{g.num_vertices()},
+        num_threads{std::max(1, num_threads)},
+        seen(n),
+        visit(n),
+        next(n) {}
+
+  // traverse from a batch of at most BATCH sources.
+  /// @param on_visit on_visit(i, v, depth) is called once for each search i,
+  /// i.e. the search from sources[i], and each vertex v it reaches in depth
+  /// hops. it's called concurrently from the worker threads.
+  template <typename OnVisit>
+  void run_batch(const std::span<const int> sources, OnVisit&& on_visit) {
+    assert(sources.size() <= static_cast<std::size_t>(BATCH));
+    // the bits of the unused searches are seen everywhere from the start, so
+    // that a vertex is done once seen is full.
+    Bits unused = Bits::full();
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      unused.reset(i);
+    }
+    parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+      for (std::size_t v = begin; v < end; ++v) {
+        seen[v] = unused;
+        visit[v] = Bits{};
+      }
+    });
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      const int s = sources[i];
+      if (!seen[s].test(i)) {
+        seen[s].set(i);
+        visit[s].set(i);
+        on_visit(static_cast<int>(i), s, 0);
+      }
+    }
+
+    const std::span<const int> offsets = rg.offsets();
+    const std::span<const int> targets = rg.targets();
+    for (int depth = 1;; ++depth) {
+      std::atomic<bool> found{false};
+      parallel_for(n, num_threads,
+                   [&](std::size_t begin, std::size_t end, int) {
+                     bool local_found = false;
+                     for (std::size_t w = begin; w < end; ++w) {
+                       if (seen[w].is_full()) {
+                         next[w] = Bits{};
+                         continue;
+                       }
+                       Bits reach;
+                       for (int i = offsets[w]; i < offsets[w + 1]; ++i) {
+                         reach |= visit[targets[i]];
+                       }
+                       reach.and_not(seen[w]);
+                       next[w] = reach;
+                       if (reach.none()) {
+                         continue;
+                       }
+                       local_found = true;
+                       seen[w] |= reach;
+                       reach.for_each([&](const int i) {
+                         on_visit(i, static_cast<int>(w), depth);
+                       });
+                     }
+                     if (local_found) {
+                       found.store(true, std::memory_order_relaxed);
+                     }
+                   });
+      if (!found.load(std::memory_order_relaxed)) {
+        break;
+      }
+      std::swap(visit, next);
+    }
+  }
+
+  // hop distances from any number of sources, BATCH at a time.
+  /// @return key: i, value: the hop distances from sources[i], MAX_DIST if
+  /// unreachable.
+  std::vector<std::vector<int>> hop_distances(
+      const std::span<const int> sources) {
+    std::vector<std::vector<int>> dist(sources.size(),
+                                       std::vector<int>(n, MAX_DIST));
+    for (std::size_t first = 0; first < sources.size(); first += BATCH) {
+      const std::size_t count =
+          std::min<std::size_t>(BATCH, sources.size() - first);
+      run_batch(sources.subspan(first, count),
+                [&](const int i, const int v, const int depth) {
+                  dist[first + i][v] = depth;
+                });
+    }
+    return dist;
+  }
+
+ private:
+  // one bit per search of the batch.
+  struct Bits {
+    std::array<uint64_t, K> words{};
+
+    static Bits full() {
+      Bits b;
+      b.words.fill(~uint64_t{0});
+      return b;
+    }
+    bool test(const std::size_t i) const {
+      return words[i >> 6] >> (i & 63) & 1;
+    }
+    void set(const std::size_t i) { words[i >> 6] |= uint64_t{1} << (i & 63); }
+    void reset(const std::size_t i) {
+      words[i >> 6] &= ~(uint64_t{1} << (i & 63));
+    }
+    bool none() const {
+      uint64_t any = 0;
+      for (int k = 0; k < K; ++k) {
+        any |= words[k];
+      }
+      return any == 0;
+    }
+    bool is_full() const {
+      uint64_t all = ~uint64_t{0};
+      for (int k = 0; k < K; ++k) {
+        all &= words[k];
+      }
+      return all == ~uint64_t{0};
+    }
+    Bits& operator|=(const Bits& o) {
+      for (int k = 0; k < K; ++k) {
+        words[k] |= o.words[k];
+      }
+      return *this;
+    }
+    void and_not(const Bits& o) {
+      for (int k = 0; k < K; ++k) {
+        words[k] &= ~o.words[k];
+      }
+    }
+    // fn(i) for each set bit i.
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+      for (int k = 0; k < K; ++k) {
+        for (uint64_t bits = words[k]; bits != 0; bits &= bits - 1) {
+          fn(k * 64 + __builtin_ctzll(bits));
+        }
+      }
+    }
+  };
+
+  // copies are cheap since they share the storage of the graphs.
+  const CsrGraph g;
+  const CsrGraph rg;
+  const int n;
+  const int num_threads;
+  std::vector<Bits> seen;
+  std::vector<Bits> visit;
+  std::vector<Bits> next;
+};
+
+#endif  // MS_BFS_HPP_
@@ -0,0 +1,159 @@
+#ifndef PARALLEL_HPP_
+#define PARALLEL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <thread>
+#include <vector>
+
+// minimal helpers for the parallel variants of the algorithms.
+// they are built on std::thread only, so that no extra dependency is needed.
+
+// the default #threads, i.e. the #hardware threads.
+int hardware_threads() {
+  const unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : static_cast<int>(n);
+}
+
+// split the index range [0, n) into num_threads contiguous chunks and call
+// fn(begin, end, thread_id) on each chunk concurrently.
+// the calling thread processes the first chunk itself.
+// fn is called at most once per thread and never with an empty chunk, except
+// that n == 0 calls nothing.
+void parallel_for(
+    const std::size_t n, int num_threads,
+    const std::function<void(std::size_t, std::size_t, int)>& fn) {
+  if (n == 0) {
+    return;
+  }
+  num_threads = static_cast<int>(
+      std::max<std::size_t>(1, std::min<std::size_t>(num_threads, n)));
+  if (num_threads == 1) {
+    fn(0, n, 0);
+    return;
+  }
+
+  const std::size_t chunk = (n + num_threads - 1) / num_threads;
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads - 1);
+  for (int t = 1; t < num_threads; ++t) {
+    const std::size_t begin = t * chunk;
+    const std::size_t end = std::min(n, begin + chunk);
+    if (begin >= end) {
+      break;
+    }
+    workers.emplace_back(fn, begin, end, t);
+  }
+  fn(0, std::min(n, chunk), 0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+// sort [first, last) by sorting num_threads chunks concurrently and then
+// merging adjacent sorted chunks pairwise, each merge round in parallel.
+// not stable, same as std::sort.
+template <typename RandomIt, typename Compare>
+void parallel_sort(const RandomIt first, const RandomIt last, Compare comp,
+                   int num_threads = hardware_threads()) {
+  const std::size_t n = std::distance(first, last);
+  // below this size the threading overhead outweighs the gain.
+  constexpr std::size_t MIN_CHUNK = 1 << 14;
+  num_threads = static_cast<int>(std::max<std::size_t>(
+      1, std::min<std::size_t>(num_threads, n / MIN_CHUNK)));
+  if (num_threads == 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  // bounds[i] is the start of the i-th sorted run.
+  std::vector<std::size_t> bounds;
+  const std::size_t chunk = (n + num_threads - 1) / num_threads;
+  for (std::size_t b = 0; b < n; b += chunk) {
+    bounds.push_back(b);
+  }
+  bounds.push_back(n);
+
+  parallel_for(bounds.size() - 1, num_threads,
+               [&](std::size_t begin, std::size_t end, int) {
+                 for (std::size_t i = begin; i < end; ++i) {
+                   std::sort(first + bounds[i], first + bounds[i + 1], comp);
+                 }
+               });
+
+  while (bounds.size() > 2) {
+    const std::size_t num_pairs = (bounds.size() - 1) / 2;
+    parallel_for(num_pairs, num_threads,
+                 [&](std::size_t begin, std::size_t end, int) {
+                   for (std::size_t i = begin; i < end; ++i) {
+                     std::inplace_merge(first + bounds[2 * i],
+                                        first + bounds[2 * i + 1],
+                                        first + bounds[2 * i + 2], comp);
+                   }
+                 });
+    std::vector<std::size_t> merged;
+    for (std::size_t i = 0; i < bounds.size(); i += 2) {
+      merged.push_back(bounds[i]);
+    }
+    if (merged.back() != n) {
+      merged.push_back(n);
+    }
+    bounds = std::move(merged);
+  }
+}
+
+template <typename RandomIt>
+void parallel_sort(const RandomIt first, const RandomIt last,
+                   int num_threads = hardware_threads()) {
+  parallel_sort(first, last, std::less<>(), num_threads);
+}
+
+// stable partition of in into out, the elements satisfying pred first.
+// each thread flags and counts its chunk, then copies it to the offsets
+// given by the prefix sums of the counts. pred is called once per element.
+/// @param out the same size as in, not overlapping it.
+/// @return #elements satisfying pred.
+template <typename T, typename Pred>
+std::size_t parallel_partition(const std::span<const T> in,
+                               const std::span<T> out, Pred&& pred,
+                               int num_threads = hardware_threads()) {
+  const std::size_t n = in.size();
+  num_threads = std::max(1, num_threads);
+  std::vector<char> flags(n);
+  // count[t] = #elements of the t-th chunk satisfying pred.
+  std::vector<std::size_t> count(num_threads, 0);
+  std::vector<std::size_t> size(num_threads, 0);
+  parallel_for(n, num_threads,
+               [&](std::size_t begin, std::size_t end, const int t) {
+                 std::size_t c = 0;
+                 for (std::size_t i = begin; i < end; ++i) {
+                   flags[i] = pred(in[i]);
+                   c += flags[i];
+                 }
+                 count[t] = c;
+                 size[t] = end - begin;
+               });
+
+  // the chunks are contiguous in thread order, so are their outputs.
+  std::vector<std::size_t> front(num_threads + 1, 0);
+  std::vector<std::size_t> back(num_threads + 1, 0);
+  for (int t = 0; t < num_threads; ++t) {
+    front[t + 1] = front[t] + count[t];
+    back[t + 1] = back[t] + size[t] - count[t];
+  }
+  const std::size_t num_true = front[num_threads];
+  parallel_for(n, num_threads,
+               [&](std::size_t begin, std::size_t end, const int t) {
+                 std::size_t f = front[t];
+                 std::size_t b = num_true + back[t];
+                 for (std::size_t i = begin; i < end; ++i) {
+                   out[flags[i] ? f++ : b++] = in[i];
+                 }
+               });
+  return num_true;
+}
+
+#endif  // PARALLEL_HPP_
@@ -0,0 +1,232 @@
+#ifndef POINT_TO_POINT_HPP_
+#define POINT_TO_POINT_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "dijkstra_engine.hpp"
+#include "shortest_path_tree.hpp"
+
+// source-sink shortest path searches which settle far fewer vertices than a
+// unidirectional Dijkstra growing a full ball around the source.
+// both are built on the Dijkstra workspace and hence reusable across queries.
+
+// bidirectional Dijkstra.
+// this algo works as below:
+// (1) run a forward search from src on g and a backward search from dst on
+//     the reversed graph, alternately advancing the side with the smaller
+//     frontier.
+// (2) whenever a side scans an edge into a vertex the other side has reached,
+//     a src -> dst path is found. keep the shortest one, mu.
+// (3) stop once the lowest keys of both frontiers sum up to at least mu,
+//     since any path not found yet has to be longer than that.
+//
+// intuition: two balls of radius r/2 around src and dst cover much less area
+// than one ball of radius r around src, about half on a plane and far less on
+// a road network.
+class BidirectionalDijkstra {
+ public:
+  explicit BidirectionalDijkstra(const CsrGraph& g)
+      : BidirectionalDijkstra(g, g.reversed()) {}
+  /// @param rg g.reversed(), passed in if the caller already has it.
+  BidirectionalDijkstra(const CsrGraph& g, const CsrGraph& rg)
+      : g{g}, rg{rg}, fwd(g.num_vertices()), bwd(g.num_vertices()) {}
+
+  ShortestPath shortest_path(const int src, const int dst) {
+    if (src == dst) {
+      return ShortestPath{.found = true, .dist = 0, .path = {src}};
+    }
+    fwd.reset();
+    bwd.reset();
+    fwd.set(src, 0, -1);
+    fwd.heap.push_or_decrease(src, 0);
+    bwd.set(dst, 0, -1);
+    bwd.heap.push_or_decrease(dst, 0);
+    GRAPH_STATS(fwd.stats.heap_pushes = bwd.stats.heap_pushes = 1;)
+
+    int mu = MAX_DIST;
+    int meet = -1;
+    const auto key = [](int, const int d) { return d; };
+    while (!fwd.heap.empty() && !bwd.heap.empty()) {
+      if (fwd.heap.top_key() + bwd.heap.top_key() >= mu) {
+        break;
+      }
+      const bool forward = fwd.heap.size() <= bwd.heap.size();
+      DijkstraWorkspace& self = forward ? fwd : bwd;
+      const DijkstraWorkspace& other = forward ? bwd : fwd;
+      dijkstra_settle_next(forward ? g : rg, self, key,
+                           [&](const int w, const int d) {
+                             const int rest = other.dist(w);
+                             if (rest != MAX_DIST && d + rest < mu) {
+                               mu = d + rest;
+                               meet = w;
+                             }
+                           });
+    }
+    if (meet == -1) {
+      return {};
+    }
+
+    // src -> ... -> meet by the forward parents, then meet -> ... -> dst by
+    // the backward parents.
+    ShortestPath sp{.found = true, .dist = mu, .path = {}};
+    for (int x = meet; x != -1; x = fwd.parent(x)) {
+      sp.path.push_back(x);
+    }
+    std::reverse(sp.path.begin(), sp.path.end());
+    for (int x = bwd.parent(meet); x != -1; x = bwd.parent(x)) {
+      sp.path.push_back(x);
+    }
+    GRAPH_STATS(sp.stats = fwd.stats; sp.stats += bwd.stats;)
+    return sp;
+  }
+
+ private:
+  const CsrGraph g;
+  const CsrGraph rg;
+  // forward search on g.
+  DijkstraWorkspace fwd;
+  // backward search on rg.
+  DijkstraWorkspace bwd;
+};
+
+// A* search.
+// this algo is Dijkstra with the heap key of a vertex v being dist(v) + h(v)
+// instead of dist(v), where h(v) is a lower bound of the distance from v to
+// dst. so vertices leading towards dst are settled first and the search stops
+// early at dst.
+// h must be consistent, i.e. h(v) <= weight(v -> w) + h(w) for every edge, so
+// that a settled vertex has its shortest distance as in Dijkstra. h = 0 is
+// plain Dijkstra.
+class AStarEngine {
+ public:
+  explicit AStarEngine(const CsrGraph& g) : g{g}, ws(g.num_vertices()) {}
+
+  /// @param h h(v) returns the lower bound of the distance from v to dst.
+  template <typename Heuristic>
+  ShortestPath shortest_path(const int src, const int dst, Heuristic&& h) {
+    ws.reset();
+    ws.set(src, 0, -1);
+    ws.heap.push_or_decrease(src, h(src));
+    GRAPH_STATS(++ws.stats.heap_pushes;)
+    const auto key = [&](const int w, const int d) { return d + h(w); };
+    while (!ws.heap.empty()) {
+      if (dijkstra_settle_next(g, ws, key, [](int, int) {}) == dst) {
+        ShortestPath sp{.found = true, .dist = ws.dist(dst), .path = {}};
+        for (int x = dst; x != -1; x = ws.parent(x)) {
+          sp.path.push_back(x);
+        }
+        std::reverse(sp.path.begin(), sp.path.end());
+        GRAPH_STATS(sp.stats = ws.stats;)
+        return sp;
+      }
+    }
+    return {};
+  }
+
+  DijkstraWorkspace& workspace() { return ws; }
+
+ private:
+  const CsrGraph g;
+  DijkstraWorkspace ws;
+};
+
+// heuristic from vertex coordinates, e.g. latitude/longitude projected to a
+// plane.
+// h(v) = the straight-line distance from v to dst times the lowest weight per
+// unit of length of any edge, which never overestimates.
+class CoordinateHeuristic {
+ public:
+  /// @param min_weight_per_unit lower bound of weight / straight-line length
+  /// over all edges.
+  CoordinateHeuristic(std::vector<double> x, std::vector<double> y,
+                      const double min_weight_per_unit)
+      : x{std::move(x)}, y{std::move(y)}, scale{min_weight_per_unit} {}
+
+  // bind the sink.
+  void set_target(const int dst) { this->dst = dst; }
+
+  int operator()(const int v) const {
+    return static_cast<int>(
+        std::floor(std::hypot(x[v] - x[dst], y[v] - y[dst]) * scale));
+  }
+
+ private:
+  std::vector<double> x;
+  std::vector<double> y;
+  double scale;
+  int dst{0};
+};
+
+// landmark (ALT) heuristic.
+// precompute the distances from and to a few landmark vertices. by the
+// triangle inequality, for each landmark L:
+//   dist(v, dst) >= dist(L, dst) - dist(L, v)
+//   dist(v, dst) >= dist(v, L) - dist(dst, L)
+// and h(v) is the largest such bound.
+// landmarks are picked by farthest-point selection: each next landmark is the
+// vertex farthest from the ones picked so far, which spreads them towards the
+// boundary of the graph where the bounds are tight.
+class LandmarkHeuristic {
+ public:
+  LandmarkHeuristic(const CsrGraph& g, const CsrGraph& rg,
+                    const int num_landmarks) {
+    const int n = g.num_vertices();
+    DijkstraEngine from_engine(g);
+    DijkstraEngine to_engine(rg);
+    // distance from v to its nearest landmark, used to pick the next one.
+    std::vector<int> nearest(n, MAX_DIST);
+    int next = 0;
+    for (int i = 0; i < num_landmarks && i < n; ++i) {
+      from.push_back(from_engine.shortest_path_tree(next).dist);
+      to.push_back(to_engine.shortest_path_tree(next).dist);
+      for (int v = 0; v < n; ++v) {
+        nearest[v] = std::min(nearest[v], from.back()[v]);
+      }
+      int farthest = next;
+      for (int v = 0; v < n; ++v) {
+        // prefer reachable far vertices, unreachable ones bound nothing.
+        if (nearest[v] != MAX_DIST && (nearest[farthest] == MAX_DIST ||
+                                       nearest[v] > nearest[farthest])) {
+          farthest = v;
+        }
+      }
+      if (nearest[farthest] == 0) {
+        break;
+      }
+      next = farthest;
+    }
+  }
+
+  int num_landmarks() const { return static_cast<int>(from.size()); }
+
+  // bind the sink.
+  void set_target(const int dst) { this->dst = dst; }
+
+  int operator()(const int v) const {
+    int h = 0;
+    for (int i = 0; i < num_landmarks(); ++i) {
+      const std::vector<int>& f = from[i];
+      const std::vector<int>& t = to[i];
+      if (f[dst] != MAX_DIST && f[v] != MAX_DIST) {
+        h = std::max(h, f[dst] - f[v]);
+      }
+      if (t[v] != MAX_DIST && t[dst] != MAX_DIST) {
+        h = std::max(h, t[v] - t[dst]);
+      }
+    }
+    return h;
+  }
+
+ private:
+  // from[i][v] = dist(landmark i, v).
+  std::vector<std::vector<int>> from;
+  // to[i][v] = dist(v, landmark i).
+  std::vector<std::vector<int>> to;
+  int dst{0};
+};
+
+#endif  // POINT_TO_POINT_HPP_
@@ -0,0 +1,218 @@
+#ifndef QUERY_EXECUTOR_HPP_
+#define QUERY_EXECUTOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "bfs.hpp"
+#include "csr_graph.hpp"
+#include "dijkstra_engine.hpp"
+#include "shortest_path_tree.hpp"
+#include "thread_pool.hpp"
+
+// concurrent source-sink shortest path queries on one shared CsrGraph, for
+// serving a stream of them rather than one call at a time.
+// a batch of queries is answered as below:
+// (1) the queries are grouped by algorithm and source.
+// (2) each group is one task of a work-stealing ThreadPool, so a worker busy
+//     with a far-reaching search doesn't hold back the others.
+// (3) a group is answered by one search: Dijkstra runs until all the sinks
+//     of the group are settled, BFS builds the tree of the source once.
+// (4) each worker has engines of its own, whose workspaces are reused by all
+//     its queries, so no query allocates its dist/parent arrays again.
+// the graph is only read, so any #queries may run on it at the same time.
+// vertices are the dense indices of the graph.
+
+enum class QueryAlgorithm {
+  // weighted, DijkstraEngine.
+  dijkstra,
+  // unweighted, i.e. dist = #edges, DirectionOptimizingBfs on one thread.
+  bfs,
+};
+
+struct PathQuery {
+  int src;
+  int dst;
+  QueryAlgorithm algorithm{QueryAlgorithm::dijkstra};
+};
+
+class QueryExecutor {
+ public:
+  // on_result(i, path) answers the i-th query of its batch.
+  using OnResult = std::function<void(std::size_t, ShortestPath)>;
+
+  explicit QueryExecutor(const CsrGraph& g,
+                         const int num_threads = hardware_threads())
+      : g{g},
+        engines(std::max(1, num_threads)),
+        pool(std::max(1, num_threads)) {}
+  QueryExecutor(const QueryExecutor&) = delete;
+  QueryExecutor& operator=(const QueryExecutor&) = delete;
+
+  int num_threads() const { return pool.num_threads(); }
+
+  // answer the queries asynchronously. on_result is called once per query, on
+  // the worker threads, so it must be thread-safe, and in no particular
+  // order. the queries are copied, so they need not outlive the call.
+  // a query with a src or dst out of range is answered as not found.
+  // note, the stats of a search shared by a group go to the result of its
+  // first query only, so that summing the results doesn't count them twice.
+  void submit(const std::span<const PathQuery> queries, OnResult on_result) {
+    auto batch = std::make_shared<Batch>();
+    batch->queries.assign(queries.begin(), queries.end());
+    batch->on_result = std::move(on_result);
+    std::vector<std::size_t>& order = batch->order;
+    order.resize(queries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](const std::size_t& i, const std::size_t& j) {
+                const PathQuery& a = queries[i];
+                const PathQuery& b = queries[j];
+                return a.algorithm != b.algorithm ? a.algorithm < b.algorithm
+                                                  : a.src < b.src;
+              });
+
+    std::size_t begin = 0;
+    while (begin < order.size()) {
+      const PathQuery& first = queries[order[begin]];
+      std::size_t end = begin + 1;
+      while (end < order.size() &&
+             queries[order[end]].algorithm == first.algorithm &&
+             queries[order[end]].src == first.src) {
+        ++end;
+      }
+      pool.submit([this, batch, begin, end](const int t) {
+        answer(*batch, begin, end, engines[t]);
+      });
+      begin = end;
+    }
+  }
+
+  // the same, with one future per query instead of a callback.
+  std::vector<std::future<ShortestPath>> submit(
+      const std::span<const PathQuery> queries) {
+    auto promises =
+        std::make_shared<std::vector<std::promise<ShortestPath>>>(
+            queries.size());
+    std::vector<std::future<ShortestPath>> futures;
+    futures.reserve(queries.size());
+    for (std::promise<ShortestPath>& promise : *promises) {
+      futures.push_back(promise.get_future());
+    }
+    submit(queries, [promises](const std::size_t i, ShortestPath sp) {
+      (*promises)[i].set_value(std::move(sp));
+    });
+    return futures;
+  }
+
+  // answer the queries and block until done.
+  /// @return key: the index of the query, value: its answer.
+  std::vector<ShortestPath> run(const std::span<const PathQuery> queries) {
+    std::vector<std::future<ShortestPath>> futures = submit(queries);
+    std::vector<ShortestPath> results;
+    results.reserve(futures.size());
+    for (std::future<ShortestPath>& future : futures) {
+      results.push_back(future.get());
+    }
+    return results;
+  }
+
+  // block until all batches submitted so far are answered.
+  void wait() { pool.wait(); }
+
+ private:
+  struct Batch {
+    std::vector<PathQuery> queries;
+    // the query indices grouped by algorithm and source.
+    std::vector<std::size_t> order;
+    OnResult on_result;
+  };
+
+  // the engines of one worker, built on its first query of each algorithm.
+  // on cache lines of their own, since each worker writes its own.
+  struct alignas(64) Engines {
+    std::optional<DijkstraEngine> dijkstra;
+    std::optional<DirectionOptimizingBfs> bfs;
+    // reused for the sinks of each group.
+    std::vector<int> dsts;
+  };
+
+  bool valid(const int v) const { return v >= 0 && v < g.num_vertices(); }
+
+  // answer the queries order[begin, end) of the batch, all of the same
+  // algorithm and source.
+  void answer(const Batch& batch, const std::size_t begin,
+              const std::size_t end, Engines& e) {
+    const PathQuery& first = batch.queries[batch.order[begin]];
+    const int src = first.src;
+    if (!valid(src)) {
+      for (std::size_t k = begin; k < end; ++k) {
+        batch.on_result(batch.order[k], ShortestPath{});
+      }
+      return;
+    }
+
+    if (first.algorithm == QueryAlgorithm::bfs) {
+      if (!e.bfs) {
+        std::call_once(reversed_once, [this] { rg = g.reversed(); });
+        e.bfs.emplace(g, rg, 1);
+      }
+      ShortestPathTree tree = e.bfs->run(src);
+      for (std::size_t k = begin; k < end; ++k) {
+        const int dst = batch.queries[batch.order[k]].dst;
+        ShortestPath sp =
+            valid(dst) ? tree.shortest_path(dst) : ShortestPath{};
+        GRAPH_STATS(if (k == begin) { sp.stats = std::move(tree.stats); })
+        batch.on_result(batch.order[k], std::move(sp));
+      }
+      return;
+    }
+
+    if (!e.dijkstra) {
+      e.dijkstra.emplace(g);
+    }
+    DijkstraEngine& engine = *e.dijkstra;
+    e.dsts.clear();
+    for (std::size_t k = begin; k < end; ++k) {
+      const int dst = batch.queries[batch.order[k]].dst;
+      if (valid(dst)) {
+        e.dsts.push_back(dst);
+      }
+    }
+    engine.run(src, e.dsts);
+    for (std::size_t k = begin; k < end; ++k) {
+      const int dst = batch.queries[batch.order[k]].dst;
+      ShortestPath sp;
+      if (valid(dst) && engine.settled(dst)) {
+        sp.found = true;
+        sp.dist = engine.dist(dst);
+        sp.path = engine.path(dst);
+      }
+      GRAPH_STATS(if (k == begin) { sp.stats = engine.workspace().stats; })
+      batch.on_result(batch.order[k], std::move(sp));
+    }
+  }
+
+  // a copy shares the storage of the graph, see DijkstraEngine.
+  const CsrGraph g;
+  // g.reversed(), for the bottom-up steps of BFS. built on the first BFS
+  // query.
+  CsrGraph rg;
+  std::once_flag reversed_once;
+  // key: worker id.
+  std::vector<Engines> engines;
+  // last, so that it's destroyed first, i.e. its queued tasks still run on
+  // the members above.
+  ThreadPool pool;
+};
+
+#endif  // QUERY_EXECUTOR_HPP_
@@ -0,0 +1,363 @@
+#ifndef REORDERING_HPP_
+#define REORDERING_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "parallel.hpp"
+#include "shortest_path_tree.hpp"
+
+// vertex reordering of a CsrGraph for memory locality.
+// the dense indices follow the order of the original ids, which is often
+// random w.r.t. the structure of the graph, so a traversal jumps all over the
+// per-vertex arrays. relabeling the vertices such that neighbors get close
+// indices turns those jumps into nearby, mostly cached, accesses, without
+// changing any algorithm.
+// the flow is:
+// (1) compute a Permutation of the dense indices, e.g. rcm_order(g).
+// (2) permute(g, p) builds the relabeled graph, whose vertex v is the vertex
+//     p.old_of[v] of g. its ids are 0..V-1, i.e. the new indices, so the
+//     original id of v is g.id(p.old_of[v]).
+// (3) run the algorithms on the relabeled graph, with the sources translated
+//     by p.to_new, and translate the results back by the to_old helpers.
+
+// a bijection between the dense indices of a graph (old) and those of its
+// relabeled graph (new).
+struct Permutation {
+  // key: new index, value: old index.
+  std::vector<int> old_of;
+  // key: old index, value: new index.
+  std::vector<int> new_of;
+
+  int size() const { return static_cast<int>(old_of.size()); }
+
+  int to_new(const int v) const { return new_of[v]; }
+  // -1, e.g. no parent, stays -1.
+  int to_old(const int v) const { return v == -1 ? -1 : old_of[v]; }
+
+  // a per-vertex array of the relabeled graph, e.g. ShortestPathTree::dist or
+  // SccResult::component, indexed by the old indices instead.
+  /// @param by_new key: new index.
+  /// @return key: old index.
+  template <typename T>
+  std::vector<T> to_old_keys(const std::vector<T>& by_new) const {
+    assert(static_cast<int>(by_new.size()) == size());
+    std::vector<T> by_old(by_new.size());
+    for (int v = 0; v < size(); ++v) {
+      by_old[old_of[v]] = by_new[v];
+    }
+    return by_old;
+  }
+
+  // vertices of the relabeled graph, e.g. a path or a topological order, as
+  // the old indices.
+  std::vector<int> to_old_vertices(std::vector<int> vertices) const {
+    for (int& v : vertices) {
+      v = to_old(v);
+    }
+    return vertices;
+  }
+
+  // both the keys and the parents of a shortest path tree of the relabeled
+  // graph, i.e. the tree of the same source in the original graph.
+  ShortestPathTree to_old(const ShortestPathTree& t) const {
+    return ShortestPathTree{.src = to_old(t.src),
+                            .dist = to_old_keys(t.dist),
+                            .parent = to_old_vertices(to_old_keys(t.parent)),
+                            .stats = t.stats};
+  }
+};
+
+// the permutation placing the old index order[i] at the new index i.
+/// @param order each old index exactly once.
+Permutation make_permutation(std::vector<int> order) {
+  Permutation p;
+  p.new_of.resize(order.size());
+  for (int v = 0; v < static_cast<int>(order.size()); ++v) {
+    p.new_of[order[v]] = v;
+  }
+  p.old_of = std::move(order);
+  return p;
+}
+
+// #edges of each vertex in either direction, i.e. the degree in the
+// underlying undirected graph.
+std::vector<int> total_degrees(const CsrGraph& g) {
+  std::vector<int> degree(g.num_vertices());
+  for (int v = 0; v < g.num_vertices(); ++v) {
+    degree[v] += g.degree(v);
+  }
+  for (const int& w : g.targets()) {
+    ++degree[w];
+  }
+  return degree;
+}
+
+// hubs first, i.e. descending total degree, ties by the old index.
+// the few high degree vertices, which most edges point to, get packed into a
+// few cache lines. it's the cheapest order, O(V log V), and suits the
+// power-law graphs.
+Permutation degree_order(const CsrGraph& g,
+                         const int num_threads = hardware_threads()) {
+  const std::vector<int> degree = total_degrees(g);
+  std::vector<int> order(g.num_vertices());
+  std::iota(order.begin(), order.end(), 0);
+  // ties broken by the index, so the order is the same for any #threads.
+  parallel_sort(
+      order.begin(), order.end(),
+      [&](const int a, const int b) {
+        return degree[a] != degree[b] ? degree[a] > degree[b] : a < b;
+      },
+      num_threads);
+  return make_permutation(std::move(order));
+}
+
+// fn(w) for each neighbor w of v in either direction.
+/// @param rg g.reversed().
+template <typename Fn>
+void for_each_undirected_neighbor(const CsrGraph& g, const CsrGraph& rg,
+                                  const int v, Fn&& fn) {
+  const std::span<const int> targets = g.targets();
+  const std::span<const int> sources = rg.targets();
+  for (int i = g.offsets()[v]; i < g.offsets()[v + 1]; ++i) {
+    fn(targets[i]);
+  }
+  for (int i = rg.offsets()[v]; i < rg.offsets()[v + 1]; ++i) {
+    fn(sources[i]);
+  }
+}
+
+// a vertex of about the largest eccentricity in the component of s, after
+// George and Liu: BFS from the root, move the root to a min degree vertex of
+// the last level, and repeat while the eccentricity grows.
+/// @param level all -1, and so again on return.
+int pseudo_peripheral(const CsrGraph& g, const CsrGraph& rg,
+                      const std::vector<int>& degree, const int s,
+                      std::vector<int>& level) {
+  int root = s;
+  int eccentricity = -1;
+  std::vector<int> queue;
+  for (;;) {
+    queue.assign(1, root);
+    level[root] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+      const int v = queue[head];
+      for_each_undirected_neighbor(g, rg, v, [&](const int w) {
+        if (level[w] == -1) {
+          level[w] = level[v] + 1;
+          queue.push_back(w);
+        }
+      });
+    }
+    const int last = level[queue.back()];
+    int candidate = queue.back();
+    for (auto it = queue.rbegin(); it != queue.rend() && level[*it] == last;
+         ++it) {
+      if (degree[*it] < degree[candidate]) {
+        candidate = *it;
+      }
+    }
+    for (const int& v : queue) {
+      level[v] = -1;
+    }
+    if (last <= eccentricity) {
+      return root;
+    }
+    eccentricity = last;
+    root = candidate;
+  }
+}
+
+// reverse Cuthill-McKee on the underlying undirected graph.
+// this algo works as below:
+// (1) for each component, in the order of its min degree vertex, start from a
+//     pseudo-peripheral vertex, i.e. one end of a long shortest path.
+// (2) BFS from there, appending the unvisited neighbors of each vertex in
+//     ascending degree.
+// (3) reverse the whole order.
+// a BFS level only has edges to itself and the adjacent levels, and the
+// levels are numbered consecutively, so the index distance of the edges, i.e.
+// the bandwidth, stays small. it suits the meshes and road networks, whose
+// BFS levels are narrow. O(E log E) at worst for the sorting by degree.
+Permutation rcm_order(const CsrGraph& g) {
+  const int n = g.num_vertices();
+  const CsrGraph rg = g.reversed();
+  const std::vector<int> degree = total_degrees(g);
+  const auto by_degree = [&](const int a, const int b) {
+    return degree[a] < degree[b];
+  };
+
+  std::vector<int> starts(n);
+  std::iota(starts.begin(), starts.end(), 0);
+  std::stable_sort(starts.begin(), starts.end(), by_degree);
+
+  std::vector<int> order;
+  order.reserve(n);
+  std::vector<char> placed(n, 0);
+  std::vector<int> level(n, -1);
+  for (const int& s : starts) {
+    if (placed[s]) {
+      continue;
+    }
+    const int root = pseudo_peripheral(g, rg, degree, s, level);
+    // order doubles as the BFS queue.
+    std::size_t head = order.size();
+    order.push_back(root);
+    placed[root] = 1;
+    while (head < order.size()) {
+      const int v = order[head++];
+      const std::size_t first = order.size();
+      for_each_undirected_neighbor(g, rg, v, [&](const int w) {
+        if (!placed[w]) {
+          placed[w] = 1;
+          order.push_back(w);
+        }
+      });
+      std::stable_sort(order.begin() + first, order.end(), by_degree);
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return make_permutation(std::move(order));
+}
+
+// communities, i.e. densely connected groups of vertices, one after another.
+// a lightweight stand-in for Rabbit order, which builds the communities by
+// hierarchical merging: here they are found by label propagation on the
+// underlying undirected graph instead.
+// this algo works as below:
+// (1) each vertex starts with its own label.
+// (2) in each round, each vertex in the index order takes the label most
+//     frequent among its neighbors, keeping its own on a tie with it and
+//     taking the smallest label on other ties. stop after a round without a
+//     change or max_rounds rounds.
+// (3) a community is the vertices of a label. the communities are ordered by
+//     their first member in the index order, and the members of each keep
+//     their relative order.
+// most edges end up inside a community, i.e. within a short index range. each
+// round costs O(V + E).
+Permutation community_order(const CsrGraph& g, const int max_rounds = 10) {
+  const int n = g.num_vertices();
+  const CsrGraph rg = g.reversed();
+  std::vector<int> label(n);
+  std::iota(label.begin(), label.end(), 0);
+
+  // key: label, value: its frequency among the neighbors of the current
+  // vertex. all 0 between the vertices.
+  std::vector<int> count(n, 0);
+  std::vector<int> seen;
+  for (int round = 0; round < max_rounds; ++round) {
+    bool changed = false;
+    for (int v = 0; v < n; ++v) {
+      for_each_undirected_neighbor(g, rg, v, [&](const int w) {
+        if (count[label[w]]++ == 0) {
+          seen.push_back(label[w]);
+        }
+      });
+      int best = label[v];
+      int best_count = count[best];
+      for (const int& l : seen) {
+        if (count[l] > best_count ||
+            (count[l] == best_count && l < best && best != label[v])) {
+          best = l;
+          best_count = count[l];
+        }
+        count[l] = 0;
+      }
+      seen.clear();
+      if (best != label[v]) {
+        label[v] = best;
+        changed = true;
+      }
+    }
+    if (!changed) {
+      break;
+    }
+  }
+
+  // key: label, value: the rank of its community, by the first member.
+  std::vector<int> rank(n, -1);
+  int num_communities = 0;
+  for (int v = 0; v < n; ++v) {
+    if (rank[label[v]] == -1) {
+      rank[label[v]] = num_communities++;
+    }
+  }
+  // a counting sort of the vertices by the rank of their community.
+  std::vector<int> offsets(num_communities + 1, 0);
+  for (int v = 0; v < n; ++v) {
+    ++offsets[rank[label[v]] + 1];
+  }
+  for (int c = 0; c < num_communities; ++c) {
+    offsets[c + 1] += offsets[c];
+  }
+  std::vector<int> order(n);
+  for (int v = 0; v < n; ++v) {
+    order[offsets[rank[label[v]]]++] = v;
+  }
+  return make_permutation(std::move(order));
+}
+
+// the graph g relabeled by p: the vertex v is the vertex p.old_of[v] of g, and
+// an edge v -> w of g is the edge p.new_of[v] -> p.new_of[w]. the ids are the
+// new indices 0..V-1, see above for the original ones.
+// the edges of each vertex are sorted by target, so that a scan walks the
+// per-vertex arrays forward. the vertices are split among the threads.
+CsrGraph permute(const CsrGraph& g, const Permutation& p,
+                 const int num_threads = hardware_threads()) {
+  assert(p.size() == g.num_vertices());
+  // owned storage of the relabeled arrays, kept alive by the view.
+  struct Arrays {
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<int> weights;
+    std::vector<int> ids;
+  };
+  const int n = g.num_vertices();
+  auto arrays = std::make_shared<Arrays>();
+  std::vector<int>& offsets = arrays->offsets;
+  offsets.assign(n + 1, 0);
+  for (int v = 0; v < n; ++v) {
+    offsets[v + 1] = offsets[v] + g.degree(p.old_of[v]);
+  }
+  arrays->targets.resize(g.num_edges());
+  arrays->weights.resize(g.num_edges());
+  arrays->ids.resize(n);
+  std::iota(arrays->ids.begin(), arrays->ids.end(), 0);
+
+  const std::span<const int> old_offsets = g.offsets();
+  const std::span<const int> old_targets = g.targets();
+  const std::span<const int> old_weights = g.weights();
+  parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+    // {target, weight} of one vertex, to sort them together.
+    std::vector<std::pair<int, int>> local;
+    for (std::size_t v = begin; v < end; ++v) {
+      const int old = p.old_of[v];
+      local.clear();
+      for (int i = old_offsets[old]; i < old_offsets[old + 1]; ++i) {
+        local.emplace_back(p.new_of[old_targets[i]], old_weights[i]);
+      }
+      std::sort(local.begin(), local.end());
+      int slot = offsets[v];
+      for (const auto& [w, weight] : local) {
+        arrays->targets[slot] = w;
+        arrays->weights[slot] = weight;
+        ++slot;
+      }
+    }
+  });
+
+  const std::span<const int> new_offsets = arrays->offsets;
+  const std::span<const int> new_targets = arrays->targets;
+  const std::span<const int> new_weights = arrays->weights;
+  const std::span<const int> ids = arrays->ids;
+  return CsrGraph::view(std::move(arrays), new_offsets, new_targets,
+                        new_weights, ids);
+}
+
+#endif  // REORDERING_HPP_
@@ -1,7 +1,9 @@
 #ifndef SHORTEST_PATH_HPP_
 #define SHORTEST_PATH_HPP_
 
+#include <deque>
 #include <list>
+#include <memory_resource>
 #include <queue>
 #include <stack>
 #include <unordered_map>
@@ -9,6 +11,8 @@
 #include <vector>
 
 #include "graph.hpp"
+#include "shortest_path_tree.hpp"
+#include "workspace.hpp"
 
 // algorithms for finding the shortest path.
 // there're generally three categories of problems:
@@ -25,10 +29,21 @@
 
 // you also have to state that if the edge can has negative weight.
 
+// for serving many queries on one graph, see DijkstraEngine in
+// dijkstra_engine.hpp, which works on a CsrGraph and returns the results as
+// data.
+
+// the graph algorithms below allocate their maps and sets from a Workspace,
+// by default the one of the calling thread, see workspace.hpp. they leave
+// their stats in ws.stats().
+
 // helper function to print the path from src to dst.
-void print_path(const int src, const int dst,
-                const std::unordered_map<int, int>& parent) {
-  std::stack<int> s;
+/// @param parent a map from vertex to parent, e.g. std::unordered_map or
+/// std::pmr::unordered_map.
+template <typename Parent>
+void print_path(const int src, const int dst, const Parent& parent,
+                Workspace& ws = Workspace::for_this_thread()) {
+  std::stack<int, std::pmr::deque<int>> s(ws.resource());
   for (int x = dst; x != src; x = parent.at(x)) {
     s.push(x);
   }
@@ -51,31 +66,46 @@ void print_path(const int src, const int dst,
 //
 // intuition: it's like a radio broadcasting from the source vertex. When the
 // radio reaches the destination, the shortest path is found.
+//
+// see DirectionOptimizingBfs in bfs.hpp for the parallel variant on a
+// CsrGraph, which returns the hop distances and parents of all vertices.
 /// @return false if no path from src to dst.
-bool bfs_sssp(const Graph& g, const int src, const int dst) {
-  std::queue<int> q;
-  std::unordered_map<int, int> parent;
-  std::unordered_set<int> visited;  // used to fight against cycle.s
-
+template <typename G>
+bool bfs_sssp(const G& g, const int src, const int dst,
+              Workspace& ws = Workspace::for_this_thread()) {
+  std::queue<int, std::pmr::deque<int>> q(ws.resource());
+  std::pmr::unordered_map<int, int> parent(ws.resource());
+  // used to fight against cycle.s
+  std::pmr::unordered_set<int> visited(ws.resource());
+
+  GRAPH_STATS(AlgoStats& stats = ws.stats(); stats.clear();
+              PhaseTimer timer(stats, "bfs");)
+
+  // a vertex is marked visited when pushed rather than when popped, so that
+  // it's pushed only once, by the first vertex reaching it, i.e. its parent.
   q.push(src);
+  visited.insert(src);
 
+  GRAPH_STATS(std::size_t level = 0;)
   while (!q.empty()) {
     const int lvl_cnt = q.size();
+    GRAPH_STATS(stats.add_frontier(level++, lvl_cnt);)
     for (int i = 0; i < lvl_cnt; ++i) {
       const int v = q.front();
       q.pop();
-
-      visited.insert(v);
+      GRAPH_STATS(++stats.vertices_settled;)
 
       if (v == dst) {
         // print the shortest path.
-        print_path(src, dst, parent);
+        print_path(src, dst, parent, ws);
         return true;
       }
 
       // dive into the next level.
       for (const Edge& e : g.edges(v)) {
-        if (visited.count(e.w) == 0) {
+        GRAPH_STATS(++stats.edges_scanned;)
+        if (visited.insert(e.w).second) {
+          parent[e.w] = v;
           q.push(e.w);
         }
       }
@@ -107,7 +137,9 @@ bool bfs_sssp(const Graph& g, const int src, const int dst) {
 // relaxed vertices will be pushed in to the queue and the algorithm terminates
 // when the queue is empty, so eventually all vertices connected with the source
 // vertex must be relaxed and hence the shortest path is obtained.
-bool dijkstra_sssp(const Graph& g, const int src, const int dst) {
+template <typename G>
+bool dijkstra_sssp(const G& g, const int src, const int dst,
+                   Workspace& ws = Workspace::for_this_thread()) {
   // {vertex, current distance from src to this vertex}.
   using Pair = std::pair<int, int>;
   // used to construct min-heap: lowest dist at the top, lower vertex id at the
@@ -118,33 +150,45 @@ bool dijkstra_sssp(const Graph& g, const int src, const int dst) {
     }
     return a.first >= b.first;
   };
-  std::priority_queue<Pair, std::vector<Pair>, decltype(cmp)> pq(cmp);
+  std::priority_queue<Pair, std::pmr::vector<Pair>, decltype(cmp)> pq(
+      cmp, std::pmr::vector<Pair>(ws.resource()));
+  GRAPH_STATS(AlgoStats& stats = ws.stats(); stats.clear();
+              PhaseTimer timer(stats, "dijkstra");)
 
   // key: vertex, value: known smallest distance to this vertex from the src
   // vertex.
-  std::unordered_map<int, int> dist_to;
+  std::pmr::unordered_map<int, int> dist_to(ws.resource());
 
   // initially, we have no info about vertices except the src vertex, and hence
   // the distances are positive inf.
   for (const int& v : g.all_vertices()) {
-    // do not use INT32_MAX to avoid integer overflow.
-    dist_to[v] = INT32_MAX;
+    dist_to[v] = MAX_DIST;
   }
   dist_to[src] = 0;
 
   pq.push({src, dist_to[src]});
+  GRAPH_STATS(++stats.heap_pushes;)
 
   // parent mapping in the shorest path tree.
   // used to reconstruct the shorest path.
-  std::unordered_map<int, int> parent;
+  std::pmr::unordered_map<int, int> parent(ws.resource());
   parent[src] = -1;
 
   while (!pq.empty()) {
     const auto [v, dist_to_v] = pq.top();
     pq.pop();
+    GRAPH_STATS(++stats.heap_pops;)
+
+    // a vertex may be pushed once per relaxation, skip the stale entries whose
+    // distance has been lowered since they were pushed.
+    if (dist_to_v > dist_to[v]) {
+      GRAPH_STATS(++stats.stale_pops;)
+      continue;
+    }
+    GRAPH_STATS(++stats.vertices_settled;)
 
     if (v == dst) {
-      print_path(src, dst, parent);
+      print_path(src, dst, parent, ws);
       return true;
     }
 
@@ -155,9 +199,11 @@ bool dijkstra_sssp(const Graph& g, const int src, const int dst) {
       // from another perspective, the distance to a vertex is like the force in
       // physics, by relaxing a vertex, the force on it is reduced, i.e. the
       // distance is reduced.
+      GRAPH_STATS(++stats.edges_scanned;)
       if (dist_to[e.w] > dist_to_v + e.weight) {
         dist_to[e.w] = dist_to_v + e.weight;
         parent[e.w] = v;
+        GRAPH_STATS(++stats.edges_relaxed; ++stats.heap_pushes;)
 
         // we can also put this statement outside the if scope, as long as you
         // have ensured that e.w is not relaxed yet.
@@ -190,45 +236,70 @@ bool dijkstra_sssp(const Graph& g, const int src, const int dst) {
 // path is src -> n1 -> n2 -> ... -> dst. After the i-th pass of vertex
 // relaxation, the shortest path from src -> ni must have been found. Since the
 // shortest can at most have V - 1 edges and hence V - 1 passes of vertex
-// relaxation is enough to find the shortest path if there is one.
-bool bellman_ford_sssp(const Graph& g, const int src, const int dst) {
-  std::unordered_map<int, int> dist_to;
-  for (const int& v : g.all_vertices()) {
-    // do not use INT32_MAX to avoid integer overflow.
-    dist_to[v] = INT32_MAX / 2;
+// relaxation is enough to find the shortest path if there is one. and if a
+// pass changes nothing, later passes change nothing either, so stop early.
+//
+// see bellman_ford.hpp for the flat array, SPFA and parallel variants on a
+// CsrGraph, which also return the negative cycle.
+template <typename G>
+bool bellman_ford_sssp(const G& g, const int src, const int dst,
+                       Workspace& ws = Workspace::for_this_thread()) {
+  const auto& vertices = g.all_vertices();
+  std::pmr::unordered_map<int, int> dist_to(ws.resource());
+  for (const int& v : vertices) {
+    dist_to[v] = MAX_DIST;
   }
   dist_to[src] = 0;
 
-  std::unordered_map<int, int> parent;
+  std::pmr::unordered_map<int, int> parent(ws.resource());
   parent[src] = -1;
+  GRAPH_STATS(AlgoStats& stats = ws.stats(); stats.clear();
+              PhaseTimer relax_timer(stats, "relax");)
 
   // V - 1 passes of vertex relaxation.
   // note, if you want to find the shortest path from src to dst with at most k
   // #edges, you can only do k passes of vertex relaxation.
-  for (int i = 0; i < g.all_vertices().size() - 1; ++i) {
-    for (const int& v : g.all_vertices()) {
+  const int num_vertices = static_cast<int>(vertices.size());
+  for (int i = 0; i < num_vertices - 1; ++i) {
+    bool changed = false;
+    for (const int& v : vertices) {
+      const int dist_to_v = dist_to[v];
+      // an unreachable vertex must not lower its neighbors.
+      if (dist_to_v == MAX_DIST) {
+        continue;
+      }
       for (const Edge& e : g.edges(v)) {
-        if (dist_to[e.w] > dist_to[v] + e.weight) {
-          dist_to[e.w] = dist_to[v] + e.weight;
+        GRAPH_STATS(++stats.edges_scanned;)
+        int& dist_to_w = dist_to[e.w];
+        if (dist_to_w > dist_to_v + e.weight) {
+          dist_to_w = dist_to_v + e.weight;
           parent[e.w] = v;
+          changed = true;
+          GRAPH_STATS(++stats.edges_relaxed;)
         }
       }
     }
+    if (!changed) {
+      break;
+    }
   }
+  GRAPH_STATS(relax_timer.stop(); PhaseTimer check_timer(stats, "check");)
 
   // check if we can reach dst from src.
-  if (dist_to[dst] == INT32_MAX / 2) {
+  if (dist_to[dst] == MAX_DIST) {
     return false;
   }
 
   // check if there's negative-weight edge.
   for (const Edge& e : g.all_edges()) {
-    if (dist_to[e.w] > dist_to[e.v] + e.weight) {
+    GRAPH_STATS(++stats.edges_scanned;)
+    if (dist_to[e.v] != MAX_DIST &&
+        dist_to[e.w] > dist_to[e.v] + e.weight) {
       return false;
     }
   }
 
-  print_path(src, dst, parent);
+  print_path(src, dst, parent, ws);
 
   return true;
 }
@@ -255,9 +326,10 @@ bool bellman_ford_sssp(const Graph& g, const int src, const int dst) {
 // since the path i -> .. -> k -> .. -> j may contain many middle vertices k, we
 // have to examine the shorter paths first. So this algo first computes the top
 // left portion of the matrix and then proceeds to the bottom right portion.
-std::vector<int> get_path(
-    int v, const int w,
-    const std::unordered_map<int, std::unordered_map<int, int>>& next) {
+/// @param next a map of maps, e.g. std::unordered_map or
+/// std::pmr::unordered_map.
+template <typename Next>
+std::vector<int> get_path(int v, const int w, const Next& next) {
   if (next.at(v).at(w) == -1) {
     return {};
   }
@@ -270,9 +342,8 @@ std::vector<int> get_path(
   return path;
 }
 
-void print_all_paths(
-    const Graph& g,
-    const std::unordered_map<int, std::unordered_map<int, int>>& next) {
+template <typename G, typename Next>
+void print_all_paths(const G& g, const Next& next) {
   for (const int& v : g.all_vertices()) {
     for (const int& w : g.all_vertices()) {
       const std::vector<int> path = get_path(v, w, next);
@@ -284,16 +355,21 @@ void print_all_paths(
   }
 }
 
-bool floyd_warshall_apsp(const Graph& g) {
+// see floyd_warshall.hpp for the blocked and vectorized variant on a dense
+// matrix, which scales to 10k-vertex graphs.
+template <typename G>
+bool floyd_warshall_apsp(const G& g,
+                         Workspace& ws = Workspace::for_this_thread()) {
+  // the inner maps get the resource of the outer by uses-allocator
+  // construction.
+  using Matrix =
+      std::pmr::unordered_map<int, std::pmr::unordered_map<int, int>>;
   // dist[i][j] = known smallest distance from i to j.
-  std::unordered_map<int, std::unordered_map<int, int>> dist;
+  Matrix dist(ws.resource());
   // FIXME: figure out the meaning of next[i][j].
   // next[i][j] = the next middle vertex k in the path i -> .. -> k -> j.
   // if the path is simply i -> j, i.e. no middle vertices, then k = i.
-  std::unordered_map<int, std::unordered_map<int, int>> next;
-
-  // do not use INT32_MAX to avoid integer overflow.
-  constexpr int MAX_DIST = INT32_MAX / 2;
+  Matrix next(ws.resource());
 
   for (const int& v : g.all_vertices()) {
     for (const int& w : g.all_vertices()) {
@@ -320,7 +396,10 @@ bool floyd_warshall_apsp(const Graph& g) {
       for (const int& j : g.all_vertices()) {
         // if using the vertex k as the middle vertex would construct a path
         // with less distance from i to j, then use it.
-        if (dist[i][j] > dist[i][k] + dist[k][j]) {
+        // a path through an unreachable k must not count, or a negative
+        // dist[k][j] would lower the MAX_DIST of dist[i][k].
+        if (dist[i][k] != MAX_DIST && dist[k][j] != MAX_DIST &&
+            dist[i][j] > dist[i][k] + dist[k][j]) {
           dist[i][j] = dist[i][k] + dist[k][j];
           // the next middle vertex in the path i -> .. -> k -> .. -> next -> j
           // is the next middle vertex in the path k -> .. -> next -> j.
@@ -328,16 +407,19 @@ bool floyd_warshall_apsp(const Graph& g) {
           // the shortest path from i to j.
           next[i][j] = next[i][k];
         }
+      }
+    }
 
-        // FIXME: is this explanation correct?
-        // since initially dist[i][i] == 0 and the above if condition must be
-        // false. the exception is that there exists a negative-weight edge in
-        // the path i -> .. -> k -> .. -> i and hence the above if condition
-        // evaluates to true and the dist[i][i] becomes negative.
-        if (dist[i][i] < 0) {
-          // found a negative-weight edge.
-          return false;
-        }
+    // FIXME: is this explanation correct?
+    // since initially dist[i][i] == 0 and the above if condition must be
+    // false. the exception is that there exists a negative-weight edge in
+    // the path i -> .. -> k -> .. -> i and hence the above if condition
+    // evaluates to true and the dist[i][i] becomes negative.
+    // it's checked once per middle vertex rather than in the innermost loop.
+    for (const int& i : g.all_vertices()) {
+      if (dist[i][i] < 0) {
+        // found a negative-weight edge.
+        return false;
       }
     }
   }
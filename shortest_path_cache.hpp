@@ -0,0 +1,153 @@
+#ifndef SHORTEST_PATH_CACHE_HPP_
+#define SHORTEST_PATH_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.hpp"
+#include "dijkstra_engine.hpp"
+#include "graph.hpp"
+#include "shortest_path_tree.hpp"
+
+// opt-in cache of the single source shortest path trees of a Graph, for
+// query logs where a few sources recur, each call asking for one path only.
+// the first query from a source runs Dijkstra to all vertices and keeps the
+// tree, i.e. a dist and a parent array over the dense vertex indices. later
+// queries from that source, to any dst, walk the cached parents, i.e. cost
+// O(path length) instead of a search.
+//
+// the trees are keyed by (graph version, src), see BasicGraph::version. once
+// the graph changes, e.g. by add_edge, the next query drops all trees of the
+// old version, so a cached tree is never stale. the searches run on a
+// CsrGraph snapshot of the current version, which also maps the ids to the
+// dense indices.
+//
+// the trees take up to a memory budget. beyond it, the least recently used
+// trees are evicted. a tree above the budget by itself is not cached.
+// non-negative weights only, same as dijkstra_sssp. a cache must be used by
+// one thread at a time.
+class ShortestPathCache {
+ public:
+  explicit ShortestPathCache(const std::size_t budget_bytes)
+      : budget{budget_bytes} {}
+
+  // the shortest path src -> dst, of the original vertex ids.
+  /// @return not found if either vertex is not in g.
+  template <typename Weight, typename Directedness>
+  ShortestPath shortest_path(const BasicGraph<int, Weight, Directedness>& g,
+                             const int src, const int dst) {
+    sync(g);
+    const int s = engine->graph().index(src);
+    const int d = engine->graph().index(dst);
+    if (s == -1 || d == -1) {
+      return {};
+    }
+    const ShortestPathTree& tree = find_or_build(s);
+    ShortestPath sp = tree.shortest_path(d);
+    for (int& v : sp.path) {
+      v = engine->graph().id(v);
+    }
+    return sp;
+  }
+
+  std::size_t size() const { return index.size(); }
+  std::size_t memory_used() const { return used; }
+  std::size_t memory_budget() const { return budget; }
+  // #queries answered from a cached tree, and by a new search.
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+  // drop all trees, and the snapshot.
+  void clear() {
+    lru.clear();
+    index.clear();
+    used = 0;
+    engine.reset();
+  }
+
+ private:
+  struct Entry {
+    // the dense index of the source.
+    int src;
+    ShortestPathTree tree;
+    std::size_t bytes;
+  };
+
+  // drop the trees of another version of the graph and rebuild the snapshot.
+  template <typename G>
+  void sync(const G& g) {
+    if (engine && version == g.version()) {
+      return;
+    }
+    clear();
+    engine.emplace(CsrGraph(g));
+    version = g.version();
+  }
+
+  const ShortestPathTree& find_or_build(const int s) {
+    const auto it = index.find(s);
+    if (it != index.end()) {
+      ++hits_;
+      // move to the front, i.e. the most recently used.
+      lru.splice(lru.begin(), lru, it->second);
+      return it->second->tree;
+    }
+    ++misses_;
+    ShortestPathTree tree = engine->shortest_path_tree(s);
+    const std::size_t bytes =
+        sizeof(Entry) +
+        (tree.dist.capacity() + tree.parent.capacity()) * sizeof(int);
+    if (bytes > budget) {
+      // kept only until the next query, as the result of this one.
+      uncached = std::move(tree);
+      return uncached;
+    }
+    while (used + bytes > budget) {
+      used -= lru.back().bytes;
+      index.erase(lru.back().src);
+      lru.pop_back();
+    }
+    lru.push_front(Entry{.src = s, .tree = std::move(tree), .bytes = bytes});
+    index[s] = lru.begin();
+    used += bytes;
+    return lru.front().tree;
+  }
+
+  const std::size_t budget;
+  std::size_t used{0};
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+  // the version of the graph the snapshot and the trees are of.
+  uint64_t version{0};
+  // on the snapshot. empty until the first query.
+  std::optional<DijkstraEngine> engine;
+  // the most recently used first.
+  std::list<Entry> lru;
+  // key: dense index of a source, value: its entry in lru.
+  std::unordered_map<int, std::list<Entry>::iterator> index;
+  ShortestPathTree uncached;
+};
+
+// dijkstra_sssp, answered from the cache, and printed the same way.
+/// @return false if no path from src to dst.
+template <typename Weight, typename Directedness>
+bool dijkstra_sssp(const BasicGraph<int, Weight, Directedness>& g,
+                   const int src, const int dst, ShortestPathCache& cache) {
+  const ShortestPath sp = cache.shortest_path(g, src, dst);
+  if (!sp.found) {
+    return false;
+  }
+  for (const int& v : sp.path) {
+    std::cout << v << " -> ";
+  }
+  std::cout << '\n';
+  return true;
+}
+
+#endif  // SHORTEST_PATH_CACHE_HPP_
@@ -0,0 +1,62 @@
+#ifndef SHORTEST_PATH_TREE_HPP_
+#define SHORTEST_PATH_TREE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "graph.hpp"
+#include "stats.hpp"
+
+// results of the shortest path engines on a CsrGraph, returned as data instead
+// of printed. vertices are the dense indices of the graph.
+
+// distance of an unreachable vertex, see max_dist.
+constexpr int MAX_DIST = max_dist<int>;
+
+// source-sink shortest path.
+struct ShortestPath {
+  // false if no path from the source to the sink.
+  bool found{false};
+  int dist{MAX_DIST};
+  // src -> ... -> dst. empty if not found.
+  std::vector<int> path;
+  // all 0 unless built with GRAPH_ENABLE_STATS, see stats.hpp.
+  [[no_unique_address]] AlgoStats stats{};
+};
+
+// single source shortest path tree.
+struct ShortestPathTree {
+  int src{-1};
+  // key: vertex, value: distance from src, or MAX_DIST if unreachable.
+  std::vector<int> dist;
+  // key: vertex, value: parent in the tree, or -1 for src and unreachable
+  // vertices.
+  std::vector<int> parent;
+  // all 0 unless built with GRAPH_ENABLE_STATS, see stats.hpp.
+  [[no_unique_address]] AlgoStats stats{};
+
+  bool reached(const int v) const { return dist[v] != MAX_DIST; }
+
+  // src -> ... -> dst. empty if dst is unreachable.
+  std::vector<int> path_to(const int dst) const {
+    if (!reached(dst)) {
+      return {};
+    }
+    std::vector<int> path;
+    for (int x = dst; x != -1; x = parent[x]) {
+      path.push_back(x);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+  ShortestPath shortest_path(const int dst) const {
+    if (!reached(dst)) {
+      return {};
+    }
+    return ShortestPath{.found = true, .dist = dist[dst], .path = path_to(dst)};
+  }
+};
+
+#endif  // SHORTEST_PATH_TREE_HPP_
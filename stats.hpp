@@ -0,0 +1,172 @@
+#ifndef STATS_HPP_
+#define STATS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// optional counters of the work done by the algorithms, to tell why a call is
+// slow, e.g. many stale heap pops or a long tail of small BFS frontiers.
+// they are compiled in only with -DGRAPH_ENABLE_STATS. otherwise GRAPH_STATS
+// drops its statements, so no counter is touched and no clock is read, and
+// AlgoStats is an empty struct whose counters are constant 0s. the members of
+// that type are [[no_unique_address]], so they take no space either. the
+// code reading the stats builds either way.
+//
+// the parallel variants count into one AlgoStats per thread and sum them
+// with += at the end, and so can the callers for the results of many calls,
+// e.g. one query per thread.
+
+#ifdef GRAPH_ENABLE_STATS
+#define GRAPH_STATS(...) __VA_ARGS__
+constexpr bool STATS_ENABLED = true;
+#else
+#define GRAPH_STATS(...)
+constexpr bool STATS_ENABLED = false;
+#endif
+
+// the wall time of a named step of an algorithm.
+struct StatsPhase {
+  // a string literal.
+  const char* name;
+  double seconds;
+};
+
+#ifdef GRAPH_ENABLE_STATS
+struct AlgoStats {
+  using Phase = StatsPhase;
+
+  // vertices whose distance became final, e.g. the fresh heap pops of
+  // Dijkstra or the vertices of the BFS levels.
+  uint64_t vertices_settled{0};
+  // edges looked at.
+  uint64_t edges_scanned{0};
+  // edges which lowered the distance of their target.
+  uint64_t edges_relaxed{0};
+  // pushes include the decrease-keys of an indexed heap.
+  uint64_t heap_pushes{0};
+  uint64_t heap_pops{0};
+  // the pops of outdated entries skipped, for the heaps with lazy deletion.
+  uint64_t stale_pops{0};
+  // #union-find finds and the #parent links they followed in total.
+  uint64_t finds{0};
+  uint64_t find_depth{0};
+  // key: BFS level, value: #vertices of its frontier.
+  std::vector<uint64_t> frontier_sizes;
+  // in the order of their first run. a repeated phase adds up.
+  std::vector<Phase> phases;
+
+  // zero the counters, keeping the capacity of the vectors, so that a reused
+  // workspace doesn't allocate again.
+  void clear() {
+    vertices_settled = edges_scanned = edges_relaxed = 0;
+    heap_pushes = heap_pops = stale_pops = 0;
+    finds = find_depth = 0;
+    frontier_sizes.clear();
+    phases.clear();
+  }
+
+  double mean_find_depth() const {
+    return finds == 0 ? 0 : static_cast<double>(find_depth) / finds;
+  }
+
+  void add_frontier(const std::size_t level, const uint64_t size) {
+    if (frontier_sizes.size() <= level) {
+      frontier_sizes.resize(level + 1, 0);
+    }
+    frontier_sizes[level] += size;
+  }
+
+  void add_phase(const char* const name, const double seconds) {
+    const auto it =
+        std::find_if(phases.begin(), phases.end(), [&](const Phase& p) {
+          return std::strcmp(p.name, name) == 0;
+        });
+    if (it == phases.end()) {
+      phases.push_back(Phase{.name = name, .seconds = seconds});
+    } else {
+      it->seconds += seconds;
+    }
+  }
+
+  // the frontiers add up by level and the phases by name.
+  AlgoStats& operator+=(const AlgoStats& other) {
+    vertices_settled += other.vertices_settled;
+    edges_scanned += other.edges_scanned;
+    edges_relaxed += other.edges_relaxed;
+    heap_pushes += other.heap_pushes;
+    heap_pops += other.heap_pops;
+    stale_pops += other.stale_pops;
+    finds += other.finds;
+    find_depth += other.find_depth;
+    for (std::size_t l = 0; l < other.frontier_sizes.size(); ++l) {
+      add_frontier(l, other.frontier_sizes[l]);
+    }
+    for (const Phase& p : other.phases) {
+      add_phase(p.name, p.seconds);
+    }
+    return *this;
+  }
+};
+#else
+// the same interface, and nothing to count into.
+struct AlgoStats {
+  using Phase = StatsPhase;
+
+  static constexpr uint64_t vertices_settled = 0;
+  static constexpr uint64_t edges_scanned = 0;
+  static constexpr uint64_t edges_relaxed = 0;
+  static constexpr uint64_t heap_pushes = 0;
+  static constexpr uint64_t heap_pops = 0;
+  static constexpr uint64_t stale_pops = 0;
+  static constexpr uint64_t finds = 0;
+  static constexpr uint64_t find_depth = 0;
+  static inline const std::vector<uint64_t> frontier_sizes{};
+  static inline const std::vector<Phase> phases{};
+
+  void clear() {}
+  double mean_find_depth() const { return 0; }
+  void add_frontier(std::size_t, uint64_t) {}
+  void add_phase(const char*, double) {}
+  AlgoStats& operator+=(const AlgoStats&) { return *this; }
+};
+#endif  // GRAPH_ENABLE_STATS
+
+// the counters of one thread of a parallel variant, on cache lines of its
+// own so that the threads counting side by side don't contend.
+struct alignas(64) ThreadStats {
+  AlgoStats stats;
+};
+
+// add the wall time of its scope, or up to stop(), to a phase of the stats,
+// e.g.
+//   GRAPH_STATS(PhaseTimer timer(stats, "relax");)
+class PhaseTimer {
+ public:
+  PhaseTimer(AlgoStats& stats, const char* const name)
+      : stats{stats}, name{name}, start{std::chrono::steady_clock::now()} {}
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+  ~PhaseTimer() { stop(); }
+
+  // end the phase before the end of the scope. only the first call counts.
+  void stop() {
+    if (stopped) {
+      return;
+    }
+    stopped = true;
+    stats.add_phase(name, std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+  }
+
+ private:
+  AlgoStats& stats;
+  const char* name;
+  std::chrono::steady_clock::time_point start;
+  bool stopped{false};
+};
+
+#endif  // STATS_HPP_
@@ -0,0 +1,128 @@
+#ifndef STREAMING_CONNECTED_COMPONENTS_HPP_
+#define STREAMING_CONNECTED_COMPONENTS_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+#include "id_map.hpp"
+#include "union_find.hpp"
+
+// connected components of an undirected graph whose edges arrive as a stream.
+// each insert is one union in a DenseUF over the dense indices of an IdMap,
+// so the #components, the size of a component and is_connected are current
+// at any time at the cost of a find, i.e. amortized O(alpha(V)), without
+// recomputing the components from a Graph.
+// the members of each component are kept as a circular linked list over the
+// dense indices: next[v] is the next member after v. merging two components
+// splices their lists in O(1) by swapping next of any member of each, so a
+// component's members are listed in O(size) instead of scanning all
+// vertices.
+class StreamingConnectedComponents {
+ public:
+  StreamingConnectedComponents() = default;
+
+  // pre-allocate for n vertices to avoid regrowing during a bulk load.
+  void reserve(const int n) {
+    ids.reserve(n);
+    next.reserve(n);
+  }
+
+  // add the vertex v, if new, as a component by itself.
+  void add_vertex(const int v) { intern(v); }
+
+  // add the undirected edge v - w, and its vertices if new.
+  /// @return true if it merged two components.
+  bool add_edge(const int v, const int w) {
+    const int x = intern(v);
+    const int y = intern(w);
+    const int root_x = uf.find(x);
+    const int root_y = uf.find(y);
+    if (root_x == root_y) {
+      return false;
+    }
+    uf.union_vertices(root_x, root_y);
+    std::swap(next[root_x], next[root_y]);
+    return true;
+  }
+  bool add_edge(const Edge& e) { return add_edge(e.v, e.w); }
+
+  // add a batch of edges, e.g. g.all_edges() or a std::vector<Edge>.
+  /// @return #merges, i.e. the decrease of get_cc_cnt().
+  template <typename Edges>
+  int add_edges(const Edges& edges) {
+    int merges = 0;
+    for (const Edge& e : edges) {
+      merges += add_edge(e.v, e.w);
+    }
+    return merges;
+  }
+
+  bool contains(const int v) const { return ids.contains(v); }
+
+  /// @return false if v or w is not a vertex.
+  bool is_connected(const int v, const int w) {
+    const int x = ids.index(v);
+    const int y = ids.index(w);
+    return x != -1 && y != -1 && uf.is_connected(x, y);
+  }
+
+  // the id of the component of the vertex v, i.e. the root vertex of its
+  // union-find tree. note, the id may change when the component is merged.
+  /// @return -1 if v is not a vertex.
+  int component(const int v) {
+    const int x = ids.index(v);
+    return x == -1 ? -1 : ids.key(uf.find(x));
+  }
+
+  // #vertices in the component of the vertex v.
+  /// @return 0 if v is not a vertex.
+  int size(const int v) {
+    const int x = ids.index(v);
+    return x == -1 ? 0 : uf.size(x);
+  }
+
+  // fn(u) for each vertex u in the component of the vertex v, v first.
+  template <typename Fn>
+  void for_each_member(const int v, Fn&& fn) const {
+    const int x = ids.index(v);
+    if (x == -1) {
+      return;
+    }
+    int u = x;
+    do {
+      fn(ids.key(u));
+      u = next[u];
+    } while (u != x);
+  }
+
+  // the vertices in the component of the vertex v, v first.
+  std::vector<int> members(const int v) {
+    std::vector<int> ms;
+    ms.reserve(size(v));
+    for_each_member(v, [&](const int u) { ms.push_back(u); });
+    return ms;
+  }
+
+  int num_vertices() const { return ids.size(); }
+
+  int get_cc_cnt() const { return uf.get_cc_cnt(); }
+
+ private:
+  int intern(const int v) {
+    const int x = ids.intern(v);
+    if (x == static_cast<int>(next.size())) {
+      uf.add_vertex();
+      next.push_back(x);
+    }
+    return x;
+  }
+
+  IdMap<int> ids;
+  // over the dense indices.
+  DenseUF uf;
+  // key: dense index, value: the next member of its component, see above.
+  std::vector<int> next;
+};
+
+#endif  // STREAMING_CONNECTED_COMPONENTS_HPP_
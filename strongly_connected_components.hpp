@@ -1,14 +1,21 @@
 #ifndef STRONGLY_CONNECTED_COMPONENTS_HPP_
 #define STRONGLY_CONNECTED_COMPONENTS_HPP_
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <list>
+#include <memory>
+#include <span>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
-#include "connected_components.hpp"
+#include "csr_graph.hpp"
+#include "dfs.hpp"
 #include "graph.hpp"
-#include "topological_sorting.hpp"
+#include "parallel.hpp"
+#include "workspace.hpp"
 
 // algorithms to find strongly connected components in a directed graph.
 
@@ -34,30 +41,426 @@
 // 因此第二次 DFS 根据第一次 DFS 的逆后序进行，就保证了在第二次 DFS 时，每个 DFS
 // pass 只会访问同一个
 // 强连通分量，而不会访问其他强连通分量。当一个强连通分量被访问完后，才会开始访问下一个强连通分量。
-std::unordered_map<int, std::list<int>> kosaraju_scc(const Graph& g) {
-  std::vector<int> postorder;
-  std::unordered_set<int> visited;
-  for (const int& v : g.all_vertices()) {
-    if (visited.count(v) == 0) {
-      dfs(g, v, postorder, visited);
-    }
-  }
-
-  const std::vector<int> reversed_postorder(postorder.crbegin(),
-                                            postorder.crend());
+//
+// the CSR snapshots, the DFS state and the postorder are allocated from the
+// workspace, only the returned components are on the heap.
+template <typename G>
+std::unordered_map<int, std::list<int>> kosaraju_scc(
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const CsrGraph csr = as_csr_graph(g, ws.resource());
+  std::pmr::vector<int> postorder(ws.resource());
+  postorder.reserve(csr.num_vertices());
+  struct PostorderVisitor : DfsVisitor {
+    void finish(const int v) { postorder.push_back(v); }
+    std::pmr::vector<int>& postorder;
+  } postorder_visitor{{}, postorder};
+  DfsEngine(csr, ws.resource()).run_all(postorder_visitor);
 
-  // transpose the graph.
-  Graph rg = g.reversed();
-  visited.clear();
+  // transpose the graph. it keeps the dense indices of csr.
+  const CsrGraph rg = csr.reversed(ws.resource());
   std::unordered_map<int, std::list<int>> cc;
+  struct SccVisitor : DfsVisitor {
+    void discover(const int v) { members->push_back(vertex_of<G>(csr, v)); }
+    const CsrGraph& csr;
+    // the vertices of the scc being visited.
+    std::list<int>* members;
+  } scc_visitor{{}, csr, nullptr};
+  DfsEngine engine(rg, ws.resource());
   int cc_id = 0;
-  for (const int& v : reversed_postorder) {
-    if (visited.count(v) == 0) {
-      dfs(g, v, cc_id, cc, visited);
+  for (auto v = postorder.crbegin(); v != postorder.crend(); ++v) {
+    if (engine.state(*v) == DfsEngine::State::unvisited) {
+      scc_visitor.members = &cc[cc_id++];
+      engine.run(*v, scc_visitor);
     }
   }
 
   return cc;
 }
 
+// SCCs as data: a dense component id per vertex plus the condensation DAG.
+struct SccResult {
+  int num_components{0};
+  // key: dense vertex index, value: component id in [0, num_components).
+  std::vector<int> component;
+  // one vertex per component, whose id is the component id, and one edge per
+  // pair of components linked by at least one edge. the weight of an edge is
+  // #edges of g it stands for.
+  CsrGraph condensation;
+};
+
+// the condensation DAG of g for the given components.
+CsrGraph condensation_of(const CsrGraph& g, const std::vector<int>& component,
+                         const int num_components,
+                         const int num_threads = hardware_threads()) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+
+  // the inter-component edges as {from, to} packed keys, sorted so that
+  // duplicates are adjacent and the edges of a component are contiguous.
+  std::vector<std::vector<uint64_t>> local(std::max(1, num_threads));
+  parallel_for(g.num_vertices(), num_threads,
+               [&](std::size_t begin, std::size_t end, const int t) {
+                 for (std::size_t v = begin; v < end; ++v) {
+                   const int cv = component[v];
+                   for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                     const int cw = component[targets[i]];
+                     if (cv != cw) {
+                       local[t].push_back(static_cast<uint64_t>(cv) << 32 |
+                                          static_cast<uint32_t>(cw));
+                     }
+                   }
+                 }
+               });
+  std::vector<uint64_t> keys;
+  for (std::vector<uint64_t>& l : local) {
+    keys.insert(keys.end(), l.begin(), l.end());
+    l = {};
+  }
+  parallel_sort(keys.begin(), keys.end(), num_threads);
+
+  struct Arrays {
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<int> weights;
+    std::vector<int> ids;
+  };
+  auto arrays = std::make_shared<Arrays>();
+  arrays->offsets.assign(num_components + 1, 0);
+  arrays->ids.resize(num_components);
+  for (int c = 0; c < num_components; ++c) {
+    arrays->ids[c] = c;
+  }
+  for (std::size_t i = 0; i < keys.size();) {
+    std::size_t j = i;
+    while (j < keys.size() && keys[j] == keys[i]) {
+      ++j;
+    }
+    ++arrays->offsets[(keys[i] >> 32) + 1];
+    arrays->targets.push_back(static_cast<int>(static_cast<uint32_t>(keys[i])));
+    arrays->weights.push_back(static_cast<int>(j - i));
+    i = j;
+  }
+  for (int c = 0; c < num_components; ++c) {
+    arrays->offsets[c + 1] += arrays->offsets[c];
+  }
+  const std::span<const int> new_offsets = arrays->offsets;
+  const std::span<const int> new_targets = arrays->targets;
+  const std::span<const int> new_weights = arrays->weights;
+  const std::span<const int> ids = arrays->ids;
+  return CsrGraph::view(std::move(arrays), new_offsets, new_targets,
+                        new_weights, ids);
+}
+
+// Pearce's SCC over the vertices with keep(v), as an iterative DFS.
+// the components found get the ids first_id, first_id + 1, ... written into
+// component.
+/// @return #components found.
+template <typename Keep>
+int pearce_scc_into(const CsrGraph& g, Keep&& keep,
+                    std::vector<int>& component, const int first_id) {
+  const std::span<const int> offsets = g.offsets();
+  const std::span<const int> targets = g.targets();
+  const int n = g.num_vertices();
+
+  // rindex[v] is 0 if unvisited, the visit index while v is on a stack, and
+  // c, counting down from n - 1, once its component is complete. the visit
+  // indices stay below the c values, so a complete vertex never lowers the
+  // rindex of an active one.
+  std::vector<int> rindex(n, 0);
+  std::vector<char> root(n, 0);
+  // the visited vertices not assigned to a component yet.
+  std::vector<int> s;
+  struct Frame {
+    int v;
+    // the next edge slot of v to scan.
+    int next;
+  };
+  std::vector<Frame> calls;
+
+  int index = 1;
+  int c = n - 1;
+  const auto begin_visit = [&](const int v) {
+    calls.push_back(Frame{.v = v, .next = offsets[v]});
+    root[v] = 1;
+    rindex[v] = index++;
+  };
+  for (int r = 0; r < n; ++r) {
+    if (rindex[r] != 0 || !keep(r)) {
+      continue;
+    }
+    begin_visit(r);
+    while (!calls.empty()) {
+      Frame& f = calls.back();
+      const int v = f.v;
+      if (f.next < offsets[v + 1]) {
+        const int w = targets[f.next];
+        if (!keep(w)) {
+          ++f.next;
+        } else if (rindex[w] == 0) {
+          // the edge is scanned again once w is finished, to take over its
+          // rindex. f is not used after the push, which may reallocate.
+          begin_visit(w);
+        } else {
+          if (rindex[w] < rindex[v]) {
+            rindex[v] = rindex[w];
+            root[v] = 0;
+          }
+          ++f.next;
+        }
+        continue;
+      }
+
+      calls.pop_back();
+      if (!root[v]) {
+        s.push_back(v);
+        continue;
+      }
+      // v is the root of a component, made of v and the vertices above it on
+      // s with a higher or equal rindex.
+      --index;
+      while (!s.empty() && rindex[v] <= rindex[s.back()]) {
+        rindex[s.back()] = c;
+        s.pop_back();
+        --index;
+      }
+      rindex[v] = c--;
+    }
+  }
+
+  for (int v = 0; v < n; ++v) {
+    if (keep(v)) {
+      component[v] = first_id + (n - 1 - rindex[v]);
+    }
+  }
+  return n - 1 - c;
+}
+
+// Pearce's memory-efficient variant of Tarjan's algorithm.
+// this algo works as below:
+// (1) DFS, giving each vertex a visit index rindex[v] when discovered.
+// (2) on each scanned edge v -> w into a vertex whose component is not
+//     complete yet, lower rindex[v] to rindex[w]. v is then not the root of
+//     its component.
+// (3) when v finishes and is still a root, v and the vertices visited after
+//     it and not yet assigned form a component. they are popped off a stack.
+// compared to Kosaraju, one DFS pass on g suffices, and no transpose is
+// needed. compared to Tarjan, rindex replaces both the index and lowlink
+// arrays and the on-stack flags, so it's one int and one char per vertex.
+// the DFS is iterative, see DfsEngine.
+// the component ids are in reverse topological order of the condensation,
+// i.e. every edge between components goes from a higher id to a lower one.
+SccResult pearce_scc(const CsrGraph& g,
+                     const int num_threads = hardware_threads()) {
+  SccResult result;
+  result.component.assign(g.num_vertices(), -1);
+  result.num_components = pearce_scc_into(
+      g, [](int) { return true; }, result.component, 0);
+  result.condensation = condensation_of(g, result.component,
+                                        result.num_components, num_threads);
+  return result;
+}
+
+// parallel forward-backward (FW-BW) SCC with trimming.
+// this algo works as below:
+// (1) trim: a vertex without a remaining in- or out-neighbor is on no cycle
+//     and hence a component by itself. removing it may expose more such
+//     vertices, so it's repeated as a worklist, like a bidirectional Kahn.
+// (2) the remaining vertices are split into subproblems by a label,
+//     initially one. in each round, pick a pivot per subproblem and BFS
+//     forward and backward from all pivots at once, within their subproblems.
+//     the vertices reached both ways are the pivot's component. the rest are
+//     split into the reached forward only, backward only, and neither
+//     subproblems, since no component spans two of them.
+// (3) once few vertices remain, finish them with the sequential Pearce.
+//
+// intuition: on real-world graphs, trimming removes most vertices and the
+// first pivot usually hits the one giant component, so a few rounds of
+// parallel BFS do nearly all the work. on high-diameter graphs, e.g. long
+// chains, the BFS levels are small and pearce_scc is the better choice.
+// the component ids are dense but in no particular order.
+SccResult parallel_scc(const CsrGraph& g,
+                       const int num_threads = hardware_threads()) {
+  // below this #remaining vertices, the sequential Pearce finishes.
+  constexpr std::size_t SEQUENTIAL = 1 << 14;
+  // a frontier below this size is processed by the calling thread only.
+  constexpr std::size_t PARALLEL_FRONTIER = 1 << 10;
+
+  const int n = g.num_vertices();
+  const CsrGraph rg = g.reversed();
+  SccResult result;
+  std::vector<int>& component = result.component;
+  component.assign(n, -1);
+  std::atomic<int> next_id{0};
+
+  // expand a BFS frontier by fn(v, out), which pushes the vertices of the
+  // next frontier into out, until it's empty. small frontiers are expanded
+  // without spawning threads.
+  std::vector<std::vector<int>> local(std::max(1, num_threads));
+  const auto expand = [&](std::vector<int> frontier, const auto& fn) {
+    while (!frontier.empty()) {
+      if (frontier.size() < PARALLEL_FRONTIER) {
+        std::vector<int> out;
+        for (const int& v : frontier) {
+          fn(v, out);
+        }
+        frontier = std::move(out);
+        continue;
+      }
+      parallel_for(frontier.size(), num_threads,
+                   [&](std::size_t begin, std::size_t end, const int t) {
+                     for (std::size_t i = begin; i < end; ++i) {
+                       fn(frontier[i], local[t]);
+                     }
+                   });
+      frontier.clear();
+      for (std::vector<int>& l : local) {
+        frontier.insert(frontier.end(), l.begin(), l.end());
+        l.clear();
+      }
+    }
+  };
+
+  // (1) trim.
+  {
+    const auto in = std::make_unique<std::atomic<int>[]>(n);
+    const auto out = std::make_unique<std::atomic<int>[]>(n);
+    const auto trimmed = std::make_unique<std::atomic<char>[]>(n);
+    for (int v = 0; v < n; ++v) {
+      in[v].store(rg.degree(v), std::memory_order_relaxed);
+      out[v].store(g.degree(v), std::memory_order_relaxed);
+      trimmed[v].store(0, std::memory_order_relaxed);
+    }
+    std::vector<int> frontier;
+    for (int v = 0; v < n; ++v) {
+      if (g.degree(v) == 0 || rg.degree(v) == 0) {
+        trimmed[v].store(1, std::memory_order_relaxed);
+        frontier.push_back(v);
+      }
+    }
+    const auto lose = [&](std::atomic<int>* degree, const int w,
+                          std::vector<int>& next) {
+      if (degree[w].fetch_sub(1, std::memory_order_relaxed) == 1 &&
+          trimmed[w].exchange(1, std::memory_order_relaxed) == 0) {
+        next.push_back(w);
+      }
+    };
+    expand(std::move(frontier), [&](const int v, std::vector<int>& next) {
+      component[v] = next_id.fetch_add(1, std::memory_order_relaxed);
+      for (const Edge& e : g.edges(v)) {
+        lose(in.get(), e.w, next);
+      }
+      for (const Edge& e : rg.edges(v)) {
+        lose(out.get(), e.w, next);
+      }
+    });
+  }
+
+  // (2) FW-BW rounds.
+  // key: vertex, value: subproblem, or -1 if assigned to a component.
+  std::vector<int> label(n);
+  std::vector<int> active;
+  for (int v = 0; v < n; ++v) {
+    label[v] = component[v] == -1 ? 0 : -1;
+    if (label[v] == 0) {
+      active.push_back(v);
+    }
+  }
+  int num_labels = 1;
+  // bit 0: reached forward, bit 1: reached backward.
+  const auto reached = std::make_unique<std::atomic<uint8_t>[]>(n);
+  while (active.size() >= SEQUENTIAL) {
+    // the lowest vertex of each subproblem is its pivot.
+    std::vector<std::atomic<int>> pivot(num_labels);
+    for (std::atomic<int>& p : pivot) {
+      p.store(n, std::memory_order_relaxed);
+    }
+    parallel_for(active.size(), num_threads,
+                 [&](std::size_t begin, std::size_t end, int) {
+                   for (std::size_t i = begin; i < end; ++i) {
+                     const int v = active[i];
+                     reached[v].store(0, std::memory_order_relaxed);
+                     std::atomic<int>& p = pivot[label[v]];
+                     int old = p.load(std::memory_order_relaxed);
+                     while (v < old && !p.compare_exchange_weak(
+                                           old, v, std::memory_order_relaxed)) {
+                     }
+                   }
+                 });
+    std::vector<int> pivots;
+    for (const std::atomic<int>& p : pivot) {
+      const int v = p.load(std::memory_order_relaxed);
+      // a label may have been emptied by the relabeling.
+      if (v != n) {
+        pivots.push_back(v);
+      }
+    }
+
+    for (const uint8_t bit : {uint8_t{1}, uint8_t{2}}) {
+      const CsrGraph& h = bit == 1 ? g : rg;
+      for (const int& p : pivots) {
+        reached[p].fetch_or(bit, std::memory_order_relaxed);
+      }
+      expand(pivots, [&](const int v, std::vector<int>& next) {
+        for (const Edge& e : h.edges(v)) {
+          if (label[e.w] == label[v] &&
+              (reached[e.w].fetch_or(bit, std::memory_order_relaxed) & bit) ==
+                  0) {
+            next.push_back(e.w);
+          }
+        }
+      });
+    }
+
+    // the component of each pivot, and the new subproblems.
+    std::vector<int> pivot_id(num_labels, -1);
+    for (const int& p : pivots) {
+      pivot_id[label[p]] = next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+    // key: label * 3 + {0: neither, 1: forward only, 2: backward only}.
+    std::vector<int> new_label(3 * static_cast<std::size_t>(num_labels), -1);
+    for (const int& v : active) {
+      const uint8_t r = reached[v].load(std::memory_order_relaxed);
+      if (r == 3) {
+        component[v] = pivot_id[label[v]];
+        label[v] = -1;
+      } else {
+        const std::size_t key = 3 * static_cast<std::size_t>(label[v]) + r;
+        if (new_label[key] == -1) {
+          new_label[key] = 0;
+        }
+      }
+    }
+    num_labels = 0;
+    for (int& l : new_label) {
+      if (l == 0) {
+        l = num_labels++;
+      }
+    }
+    std::vector<int> remaining(active.size());
+    remaining.resize(parallel_partition<int>(
+        std::span<const int>(active), std::span<int>(remaining),
+        [&](const int v) { return label[v] != -1; }, num_threads));
+    active = std::move(remaining);
+    parallel_for(active.size(), num_threads,
+                 [&](std::size_t begin, std::size_t end, int) {
+                   for (std::size_t i = begin; i < end; ++i) {
+                     const int v = active[i];
+                     label[v] = new_label[3 * static_cast<std::size_t>(
+                                              label[v]) +
+                                          reached[v].load(
+                                              std::memory_order_relaxed)];
+                   }
+                 });
+  }
+
+  // (3) the rest.
+  result.num_components =
+      next_id.load() + pearce_scc_into(
+                           g, [&](const int v) { return component[v] == -1; },
+                           component, next_id.load());
+  result.condensation = condensation_of(g, component, result.num_components,
+                                        num_threads);
+  return result;
+}
+
 #endif  // STRONGLY_CONNECTED_COMPONENTS_HPP_
\ No newline at end of file
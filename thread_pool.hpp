@@ -0,0 +1,181 @@
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+// a fixed set of worker threads running the tasks submitted to it, with work
+// stealing. unlike parallel_for, which splits a known range up front on
+// threads started per call, the pool keeps its workers, and suits a stream of
+// tasks of uneven cost, e.g. queries.
+// this pool works as below:
+// (1) each worker has a deque of its own. a task submitted by a worker goes
+//     to the back of its deque, and a task submitted from outside goes to
+//     the deques in turn.
+// (2) a worker runs the back of its own deque first, i.e. its latest task,
+//     whose data is the most likely to be in its cache.
+// (3) once its own deque is empty, it steals the front of another deque,
+//     i.e. the oldest task there. so a worker stuck on a long task doesn't
+//     hold back the tasks queued behind it.
+// each deque has a lock of its own, so a worker contends only with the
+// thieves of its deque, not with all the other workers.
+//
+// a task is called with the id of the worker running it, 0..num_threads-1,
+// e.g. to pick per-thread scratch memory. a task must not throw, and must not
+// call wait() on its own pool.
+class ThreadPool {
+ public:
+  using Task = std::function<void(int)>;
+
+  explicit ThreadPool(const int num_threads = hardware_threads())
+      : num_threads_{std::max(1, num_threads)},
+        queues(std::make_unique<Queue[]>(num_threads_)) {
+    workers.reserve(num_threads_);
+    for (int t = 0; t < num_threads_; ++t) {
+      workers.emplace_back([this, t] { work(t); });
+    }
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // run the tasks still queued, then join the workers.
+  ~ThreadPool() {
+    {
+      const std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+
+  int num_threads() const { return num_threads_; }
+
+  void submit(Task task) {
+    const int q = current_pool == this
+                      ? current_worker
+                      : static_cast<int>(next_queue.fetch_add(
+                                             1, std::memory_order_relaxed) %
+                                         num_threads_);
+    {
+      const std::lock_guard<std::mutex> lock(queues[q].mutex);
+      queues[q].tasks.push_back(std::move(task));
+    }
+    {
+      const std::lock_guard<std::mutex> lock(mutex);
+      ++pending;
+      ++queued;
+    }
+    wake.notify_one();
+  }
+
+  // block until all tasks submitted so far are done.
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending == 0; });
+  }
+
+  // parallel_for on the workers of the pool instead of new threads, for the
+  // many short phases of an algorithm, e.g. one per bucket or level, which
+  // would otherwise pay a thread start-up each: split [0, n) into
+  // num_threads() chunks, call fn(begin, end, worker id) on them and block
+  // until done. a worker may take more than one chunk, one at a time.
+  // it waits for the other tasks too, so it must not be called from a task.
+  void parallel_for(
+      const std::size_t n,
+      const std::function<void(std::size_t, std::size_t, int)>& fn) {
+    const std::size_t chunk = (n + num_threads_ - 1) / num_threads_;
+    for (std::size_t begin = 0; begin < n; begin += chunk) {
+      const std::size_t end = std::min(n, begin + chunk);
+      submit([&fn, begin, end](const int t) { fn(begin, end, t); });
+    }
+    wait();
+  }
+
+ private:
+  // on its own cache lines, so that the locks of two deques don't contend.
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void work(const int t) {
+    current_pool = this;
+    current_worker = t;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if (queued == 0) {
+          return;
+        }
+        // reserve one of the queued tasks, so that the loop below finds one.
+        --queued;
+      }
+      take(t)(t);
+      {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+          idle.notify_all();
+        }
+      }
+    }
+  }
+
+  // the back of the own deque, or else the front of the next non-empty one.
+  Task take(const int t) {
+    // another worker may take the task reserved here from under us, but
+    // then it leaves the one it reserved, so the scan finds that one.
+    for (int i = 0;; i = (i + 1) % num_threads_) {
+      Queue& queue = queues[(t + i) % num_threads_];
+      const std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        continue;
+      }
+      Task task;
+      if (i == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      return task;
+    }
+  }
+
+  // the pool and the worker id of the calling thread, if a worker.
+  static inline thread_local const ThreadPool* current_pool = nullptr;
+  static inline thread_local int current_worker = -1;
+
+  const int num_threads_;
+  std::unique_ptr<Queue[]> queues;
+  std::atomic<unsigned> next_queue{0};
+  std::vector<std::thread> workers;
+
+  // guards the counts below.
+  std::mutex mutex;
+  // notified on a new task or on stopping.
+  std::condition_variable wake;
+  // notified when pending drops to 0.
+  std::condition_variable idle;
+  // #tasks submitted and not done yet.
+  std::size_t pending{0};
+  // #tasks in the deques and not reserved by a worker yet.
+  std::size_t queued{0};
+  bool stopping{false};
+};
+
+#endif  // THREAD_POOL_HPP_
@@ -2,14 +2,20 @@
 #define TOPOLOGICAL_SORTING_HPP_
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <iostream>
-#include <queue>
+#include <memory>
+#include <span>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
-#include "directed_cycle_detection.hpp"
+#include "csr_graph.hpp"
+#include "dfs.hpp"
 #include "graph.hpp"
+#include "parallel.hpp"
+#include "workspace.hpp"
 
 // algorithms for topogical sorting on a directed acyclic graph (DAG).
 
@@ -27,31 +33,28 @@
 // after the finish of the dfs call on a child, should the finish of the dfs
 // call on the parent.
 // the reverse of such a finish order exactly reveals the topological order.
-void dfs(const Graph& g, const int& v, std::vector<int>& postorder,
-         std::unordered_set<int>& visited) {
-  visited.insert(v);
-
-  for (const Edge& e : g.edges(v)) {
-    if (visited.count(e.w) == 0) {
-      dfs(g, e.w, postorder, visited);
-    }
-  }
-
-  postorder.push_back(v);
-}
-
-std::vector<int> dfs_topological_sorting(const Graph& g) {
-  if (dfs_detect_cycle(g)) {
-    return {};
-  }
-
+// the cycle check of (1) is folded into the DFS of (2): a back edge tells a
+// cycle.
+/// @return the topological order, or empty if there's a cycle.
+template <typename G>
+std::vector<int> dfs_topological_sorting(
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const CsrGraph csr = as_csr_graph(g, ws.resource());
   std::vector<int> postorder;
-
-  std::unordered_set<int> visited;
-  for (const int& v : g.all_vertices()) {
-    if (visited.count(v) == 0) {
-      dfs(g, v, postorder, visited);
-    }
+  postorder.reserve(csr.num_vertices());
+
+  struct Visitor : DfsVisitor {
+    void finish(const int v) { postorder.push_back(vertex_of<G>(csr, v)); }
+    void back_edge(int, int) { cycle = true; }
+    bool stop() const { return cycle; }
+    const CsrGraph& csr;
+    std::vector<int>& postorder;
+    bool cycle;
+  } visitor{{}, csr, postorder, false};
+
+  DfsEngine engine(csr, ws.resource());
+  if (!engine.run_all(visitor)) {
+    return {};
   }
 
   std::reverse(postorder.begin(), postorder.end());
@@ -73,43 +76,168 @@ std::vector<int> dfs_topological_sorting(const Graph& g) {
 // (4) eventually, all edges will be removed and hence all vertices will be of 0
 // indegree and hence this algo terminates.
 // the topological order is exactly the order vertices pushed out of the queue.
-std::vector<int> bfs_topological_sorting(const Graph& g) {
-  // note, we can also record how many vertices visited during bfs.
-  // if this number is not equal to the #vertices, then there's a cycle.
-  if (dfs_detect_cycle(g)) {
-    return {};
+// the vertices on a cycle never reach 0 indegree, so there's a cycle iff
+// fewer than #vertices vertices are visited. no separate cycle check needed.
+/// @return the topological order, or empty if there's a cycle.
+template <typename G>
+std::vector<int> bfs_topological_sorting(
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const CsrGraph csr = as_csr_graph(g, ws.resource());
+  const std::span<const int> offsets = csr.offsets();
+  const std::span<const int> targets = csr.targets();
+  const int n = csr.num_vertices();
+
+  std::pmr::vector<int> indegree(n, 0, ws.resource());
+  for (const int& w : targets) {
+    ++indegree[w];
   }
-
+  // the order doubles as the queue: [head, order.size()) are queued.
   std::vector<int> order;
-  std::queue<int> q;
-  std::unordered_map<int, int> indegree;
-  for (const int& v : g.all_vertices()) {
-    indegree[v] = 0;
+  order.reserve(n);
+  for (int v = 0; v < n; ++v) {
+    if (indegree[v] == 0) {
+      order.push_back(v);
+    }
   }
-  for (const Edge& e : g.all_edges()) {
-    ++indegree[e.w];
+  for (std::size_t head = 0; head < order.size(); ++head) {
+    const int v = order[head];
+    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+      if (--indegree[targets[i]] == 0) {
+        order.push_back(targets[i]);
+      }
+    }
   }
 
-  for (const auto& p : indegree) {
-    if (p.second == 0) {
-      q.push(p.first);
-    }
+  if (static_cast<int>(order.size()) != n) {
+    return {};
   }
+  for (int& v : order) {
+    v = vertex_of<G>(csr, v);
+  }
+  return order;
+}
+
+// a topological order grouped by level, aka. wavefronts.
+// level 0 is the vertices without in-edges, and level i + 1 is the vertices
+// whose in-neighbors are all in the levels up to i, i.e. the vertices of a
+// level only depend on earlier levels and can be processed concurrently.
+struct TopologicalLevels {
+  // the vertices level by level, in ascending dense index within a level.
+  std::vector<int> order;
+  // the vertices of level i are order[level_offsets[i], level_offsets[i + 1]).
+  std::vector<int> level_offsets{0};
 
-  while (!q.empty()) {
-    const int v = q.front();
-    q.pop();
-    order.push_back(v);
+  int num_levels() const { return static_cast<int>(level_offsets.size()) - 1; }
+  std::span<const int> level(const int i) const {
+    return std::span<const int>(order).subspan(
+        level_offsets[i], level_offsets[i + 1] - level_offsets[i]);
+  }
+  bool empty() const { return order.empty(); }
+};
 
-    for (const Edge& e : g.edges(v)) {
-      --indegree[e.w];
-      if (indegree[e.w] == 0) {
-        q.push(e.w);
+// parallel kahn algorithm, one level at a time.
+// this algo works as below:
+// (1) count the indegrees into a flat array of atomics, concurrently.
+// (2) the vertices of 0 indegree form the first frontier.
+// (3) each thread takes a chunk of the frontier and decrements the indegrees
+//     of their out-neighbors. the thread bringing an indegree to 0 owns that
+//     vertex, and pushes it to its own buffer of the next frontier.
+// (4) concatenate the buffers into the next frontier. repeat until it's empty.
+// same as bfs_topological_sorting, there's a cycle iff fewer than #vertices
+// vertices are visited.
+// which thread claims a vertex depends on the interleaving, so each level is
+// sorted to keep the result deterministic.
+/// @return the levels, in the vertices of g, or empty if there's a cycle.
+template <typename G>
+TopologicalLevels parallel_topological_levels(
+    const G& g, const int num_threads = hardware_threads()) {
+  // a frontier below this size is processed by the calling thread only.
+  constexpr std::size_t PARALLEL_FRONTIER = 1 << 10;
+
+  const CsrGraph csr = as_csr_graph(g);
+  const std::span<const int> offsets = csr.offsets();
+  const std::span<const int> targets = csr.targets();
+  const int n = csr.num_vertices();
+
+  const auto indegree = std::make_unique<std::atomic<int>[]>(n);
+  parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+    for (std::size_t v = begin; v < end; ++v) {
+      indegree[v].store(0, std::memory_order_relaxed);
+    }
+  });
+  parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end, int) {
+    for (int i = offsets[begin]; i < offsets[end]; ++i) {
+      indegree[targets[i]].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  TopologicalLevels levels;
+  levels.order.reserve(n);
+  std::vector<std::vector<int>> local(std::max(1, num_threads));
+  // append the per-thread buffers to the order as the next level.
+  const auto gather = [&]() {
+    const std::size_t first = levels.order.size();
+    for (std::vector<int>& l : local) {
+      levels.order.insert(levels.order.end(), l.begin(), l.end());
+      l.clear();
+    }
+    std::sort(levels.order.begin() + first, levels.order.end());
+    if (levels.order.size() > first) {
+      levels.level_offsets.push_back(static_cast<int>(levels.order.size()));
+    }
+  };
+
+  parallel_for(n, num_threads,
+               [&](std::size_t begin, std::size_t end, const int t) {
+                 for (std::size_t v = begin; v < end; ++v) {
+                   if (indegree[v].load(std::memory_order_relaxed) == 0) {
+                     local[t].push_back(static_cast<int>(v));
+                   }
+                 }
+               });
+  gather();
+
+  const auto relax = [&](const int v, std::vector<int>& next) {
+    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+      // acq_rel, so that the owner of w sees all its in-neighbors done.
+      if (indegree[targets[i]].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        next.push_back(targets[i]);
+      }
+    }
+  };
+  for (int l = 0; l < levels.num_levels(); ++l) {
+    const std::span<const int> frontier = levels.level(l);
+    if (frontier.size() < PARALLEL_FRONTIER) {
+      for (const int& v : frontier) {
+        relax(v, local[0]);
       }
+    } else {
+      parallel_for(frontier.size(), num_threads,
+                   [&](std::size_t begin, std::size_t end, const int t) {
+                     for (std::size_t i = begin; i < end; ++i) {
+                       relax(frontier[i], local[t]);
+                     }
+                   });
     }
+    // reserved above, so appending doesn't invalidate frontier.
+    gather();
   }
 
-  return order;
+  if (static_cast<int>(levels.order.size()) != n) {
+    return {};
+  }
+  for (int& v : levels.order) {
+    v = vertex_of<G>(csr, v);
+  }
+  return levels;
+}
+
+// one-shot wrapper of the flat order.
+/// @return the topological order, or empty if there's a cycle.
+template <typename G>
+std::vector<int> parallel_topological_sorting(
+    const G& g, const int num_threads = hardware_threads()) {
+  return parallel_topological_levels(g, num_threads).order;
 }
 
 #endif  // TOPOLOGICAL_SORTING_HPP_
\ No newline at end of file
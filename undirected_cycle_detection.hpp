@@ -1,13 +1,16 @@
 #ifndef UNDIRECTED_CYCLE_DETECTION_HPP_
 #define UNDIRECTED_CYCLE_DETECTION_HPP_
 
-#include <cassert>
-#include <stack>
-#include <unordered_map>
-#include <unordered_set>
+#include <atomic>
+#include <iostream>
+#include <vector>
 
+#include "csr_graph.hpp"
+#include "dfs.hpp"
 #include "graph.hpp"
+#include "parallel.hpp"
 #include "union_find.hpp"
+#include "workspace.hpp"
 
 // algorithms to detect a cycle in a undirected graph.
 
@@ -18,73 +21,54 @@
 // to identify sucha a case, you need to maintain a parent mapping during DFS
 // traversal. (recommended)
 // another solution is to remove duplicated edges at first.
-bool dfs(const Graph& g, const int& v, std::unordered_set<int>& visited,
-         std::unordered_set<int>& ancestors,
-         std::unordered_map<int, int>& parent) {
-  visited.insert(v);
-  ancestors.insert(v);  // ancestors of the vertex w.
-
-  for (const Edge& e : g.edges(v)) {
-    const int& w = e.w;
-    if (parent[v] == w) {
-      continue;
-    }
-
-    // find a tree edge, i.e. from parent to child.
-    if (visited.count(w) == 0) {
-      parent[w] = v;
-      if (dfs(g, w, visited, ancestors, parent)) {
-        return true;
-      }
-    } else if (ancestors.count(w) > 0) {
-      // find a back edge, i.e. from child to ancestor.
-      // this means there's a cycle:
-      // w -> ... -> v -> w.
-
-      // print the cycle.
-      std::stack<int> cycle;
-      cycle.push(w);
-      for (int x = v; x != w; x = parent.at(x)) {
-        cycle.push(x);
+// note, named apart from dfs_detect_cycle of directed_cycle_detection.hpp, so
+// that both headers can be included together.
+/// @return the cycle w - ... - v - w, listed without repeating w, or empty if
+/// there's none. vertices are those of g.
+template <typename G>
+std::vector<int> dfs_find_undirected_cycle(
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const CsrGraph csr = as_csr_graph(g, ws.resource());
+  DfsEngine engine(csr, ws.resource());
+  struct Visitor : DfsVisitor {
+    void back_edge(const int v, const int w) {
+      // the edge back to the parent is the tree edge seen from the other end.
+      if (engine.parent(v) != w) {
+        from = v;
+        to = w;
       }
-      cycle.push(w);
-      while (!cycle.empty()) {
-        std::cout << cycle.top() << " -> ";
-        cycle.pop();
-      }
-      std::cout << '\n';
-
-      return true;
     }
-    // otherwise, the vertex w is a visited vertex and not an ancestor.
-    // there're two possibilities:
-    // (1) cross edge: w is in another subtree.
-    // (2) forward edge: w is in the subtree.
-    // but these edges are not in our concern.
+    bool stop() const { return from != -1; }
+    const DfsEngine& engine;
+    // the back edge found.
+    int from;
+    int to;
+  } visitor{{}, engine, -1, -1};
+  if (engine.run_all(visitor)) {
+    return {};
   }
 
-  // ancestors form a stack and hence we need to pop the top of the stack per
-  // the system stack.
-  ancestors.erase(v);
-  return false;
+  std::vector<int> cycle = engine.tree_path(visitor.to, visitor.from);
+  for (int& x : cycle) {
+    x = vertex_of<G>(csr, x);
+  }
+  return cycle;
 }
 
-bool dfs_detect_cycle(const Graph& g) {
-  std::unordered_set<int> visited;  // visited vertices.
-
-  for (const int& v : g.all_vertices()) {
-    // ancestors of the currently visiting vertex.
-    std::unordered_set<int> ancestors;
-    // key: current vertex, val: the parent vertex of this vertex.
-    std::unordered_map<int, int> parent;
+template <typename G>
+bool dfs_detect_undirected_cycle(
+    const G& g, Workspace& ws = Workspace::for_this_thread()) {
+  const std::vector<int> cycle = dfs_find_undirected_cycle(g, ws);
+  if (cycle.empty()) {
+    return false;
+  }
 
-    if (visited.count(v) == 0) {
-      if (dfs(g, v, visited, ancestors, parent)) {
-        return true;
-      }
-    }
+  // print the cycle.
+  for (const int& x : cycle) {
+    std::cout << x << " -> ";
   }
-  return false;
+  std::cout << cycle.front() << " -> " << '\n';
+  return true;
 }
 
 // union-find works as such: iterate all edges in the graph, if the
@@ -94,8 +78,9 @@ bool dfs_detect_cycle(const Graph& g) {
 // note, you have to identify the case that the outgoing vertex is parent
 // vertex, i.e. to not consider the bidirectional edges.
 // another solution is to remove duplicated edges at first. (recommended)
-bool uf_detect_cycle(const Graph& g) {
-  UF uf(g.all_vertices());
+template <typename G>
+bool uf_detect_cycle(const G& g) {
+  auto uf = make_uf(g);
   for (const Edge& e : dedup_edges(g.all_edges())) {
     if (uf.is_connected(e.v, e.w)) {
       return true;
@@ -105,4 +90,30 @@ bool uf_detect_cycle(const Graph& g) {
   return false;
 }
 
+// parallel union-find.
+// the deduplicated edges are split among threads which union them into a
+// shared lock-free union-find. an edge whose endpoints are already connected
+// closes a cycle. this is order independent: whichever order the unions are
+// linearized in, #successful unions is V - #cc, so some union fails iff the
+// #edges exceeds the size of a spanning forest.
+bool parallel_uf_detect_cycle(const CsrGraph& g,
+                              const int num_threads = hardware_threads()) {
+  const std::vector<Edge> edges =
+      parallel_dedup_edges(g.all_edges(), DedupPolicy::first, num_threads);
+  ConcurrentUF uf(g.num_vertices());
+  std::atomic<bool> found{false};
+  parallel_for(edges.size(), num_threads,
+               [&](std::size_t begin, std::size_t end, int) {
+                 for (std::size_t i = begin; i < end; ++i) {
+                   if (found.load(std::memory_order_relaxed)) {
+                     return;
+                   }
+                   if (!uf.union_vertices(edges[i].v, edges[i].w)) {
+                     found.store(true, std::memory_order_relaxed);
+                   }
+                 }
+               });
+  return found.load();
+}
+
 #endif  // UNDIRECTED_CYCLE_DETECTION_HPP_
\ No newline at end of file
@@ -1,9 +1,18 @@
 #ifndef UNION_FIND_HPP_
 #define UNION_FIND_HPP_
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <list>
+#include <memory_resource>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stats.hpp"
 
 // union-find implementation with path-compressiond and union by rank
 // optimizations.
@@ -21,7 +30,14 @@
 class UF {
  public:
   UF() = default;
-  explicit UF(const std::list<int>& vertices) {
+  // construct from any iterable range of vertices, e.g. g.all_vertices().
+  /// @param resource where the maps are allocated, e.g. the pool of a
+  /// Workspace.
+  template <typename Vertices>
+  explicit UF(const Vertices& vertices,
+              std::pmr::memory_resource* const resource =
+                  std::pmr::get_default_resource())
+      : p(resource), rank(resource) {
     for (const int& v : vertices) {
       add_vertex(v);
     }
@@ -38,7 +54,22 @@ class UF {
 
   // find the root vertex of the given vertex.
   // a root vertex's parent is itself.
-  int find(int id) { return p[id] == id ? id : (p[id] = find(p[id])); }
+  // the path is compressed in a second pass instead of by recursion, so that a
+  // long chain won't overflow the stack.
+  int find(int id) {
+    GRAPH_STATS(++stats_.finds;)
+    int root = id;
+    while (p[root] != root) {
+      root = p[root];
+      GRAPH_STATS(++stats_.find_depth;)
+    }
+    while (p[id] != root) {
+      const int next = p[id];
+      p[id] = root;
+      id = next;
+    }
+    return root;
+  }
 
   // union two vertices by rank.
   void union_vertices(const int v, const int w) {
@@ -65,13 +96,280 @@ class UF {
 
   int get_cc_cnt() const { return cc_cnt; }
 
+  // the finds so far and their depth, see stats.hpp.
+  const AlgoStats& stats() const { return stats_; }
+
  private:
   // key: vertex id, value: parent's vertex id.
-  std::unordered_map<int, int> p;
+  std::pmr::unordered_map<int, int> p;
   // key: vertex id, value: height of the tree.
-  std::unordered_map<int, int> rank;
+  std::pmr::unordered_map<int, int> rank;
+  // #connected components.
+  int cc_cnt{0};
+  [[no_unique_address]] AlgoStats stats_;
+};
+
+// union-find for dense vertex ids 0..N-1, e.g. the vertex indices of a
+// CsrGraph.
+// compared to UF, the forest is kept in one flat vector instead of two hash
+// maps, and each slot packs the parent and the size together:
+// - p[v] >= 0: v is not a root and p[v] is its parent.
+// - p[v] < 0: v is a root and -p[v] is the #vertices in its tree.
+// union by size keeps the trees shallow as union by rank does, and path
+// splitting, i.e. linking each vertex on the find path to its grandparent
+// while stepping to its old parent, compresses the path in the same single
+// iterative pass.
+class DenseUF {
+ public:
+  DenseUF() = default;
+  explicit DenseUF(const int n) : p(n, -1), cc_cnt{n} {}
+
+  // add a new vertex and return its id, i.e. the current #vertices.
+  int add_vertex() {
+    p.push_back(-1);
+    ++cc_cnt;
+    return static_cast<int>(p.size()) - 1;
+  }
+
+  int find(int id) {
+    GRAPH_STATS(++stats_.finds;)
+    while (p[id] >= 0) {
+      const int parent = p[id];
+      if (p[parent] >= 0) {
+        // path splitting.
+        p[id] = p[parent];
+      }
+      id = parent;
+      GRAPH_STATS(++stats_.find_depth;)
+    }
+    return id;
+  }
+
+  // union two vertices by size.
+  /// @return false if they are already connected.
+  bool union_vertices(const int v, const int w) {
+    int root_v = find(v);
+    int root_w = find(w);
+    if (root_v == root_w) {
+      return false;
+    }
+    // link the smaller tree under the larger one.
+    if (p[root_v] > p[root_w]) {
+      std::swap(root_v, root_w);
+    }
+    p[root_v] += p[root_w];
+    p[root_w] = root_v;
+    --cc_cnt;
+    return true;
+  }
+
+  bool is_connected(const int v, const int w) { return find(v) == find(w); }
+
+  // #vertices in the connected component of the vertex v.
+  int size(const int v) { return -p[find(v)]; }
+
+  int get_cc_cnt() const { return cc_cnt; }
+
+  // the finds so far and their depth, see stats.hpp.
+  const AlgoStats& stats() const { return stats_; }
+
+ private:
+  // packed parent or negated tree size, see above.
+  std::vector<int> p;
   // #connected components.
   int cc_cnt{0};
+  [[no_unique_address]] AlgoStats stats_;
 };
 
+// union-find for dense vertex ids 0..N-1 which can undo its latest unions,
+// for offline algorithms exploring a tree of states, e.g. the
+// divide-and-conquer dynamic connectivity.
+// the forest is packed the same as DenseUF. but there's no path compression,
+// since an undo would then have to restore the whole path. union by size alone
+// keeps the trees O(log V) high, and each union changes two slots only, which
+// are recorded on a history stack.
+class RollbackUF {
+ public:
+  RollbackUF() = default;
+  explicit RollbackUF(const int n) : p(n, -1), cc_cnt{n} {}
+
+  int find(int id) const {
+    GRAPH_STATS(++stats_.finds;)
+    while (p[id] >= 0) {
+      id = p[id];
+      GRAPH_STATS(++stats_.find_depth;)
+    }
+    return id;
+  }
+
+  // union two vertices by size.
+  /// @return false if they are already connected.
+  bool union_vertices(const int v, const int w) {
+    int root_v = find(v);
+    int root_w = find(w);
+    if (root_v == root_w) {
+      return false;
+    }
+    if (p[root_v] > p[root_w]) {
+      std::swap(root_v, root_w);
+    }
+    history.emplace_back(root_w, p[root_w]);
+    p[root_v] += p[root_w];
+    p[root_w] = root_v;
+    --cc_cnt;
+    return true;
+  }
+
+  bool is_connected(const int v, const int w) const {
+    return find(v) == find(w);
+  }
+
+  // #vertices in the connected component of the vertex v.
+  int size(const int v) const { return -p[find(v)]; }
+
+  int get_cc_cnt() const { return cc_cnt; }
+
+  // the finds so far and their depth, see stats.hpp.
+  const AlgoStats& stats() const { return stats_; }
+
+  // the state to return to by rollback.
+  std::size_t snapshot() const { return history.size(); }
+
+  // undo the unions since the snapshot s, latest first.
+  void rollback(const std::size_t s) {
+    while (history.size() > s) {
+      const auto [root_w, size_w] = history.back();
+      history.pop_back();
+      p[p[root_w]] -= size_w;
+      p[root_w] = size_w;
+      ++cc_cnt;
+    }
+  }
+
+ private:
+  // packed parent or negated tree size, see DenseUF.
+  std::vector<int> p;
+  // #connected components.
+  int cc_cnt{0};
+  // {linked root, its packed slot before the union} per union.
+  std::vector<std::pair<int, int>> history;
+  // counted by the const finds too.
+  [[no_unique_address]] mutable AlgoStats stats_;
+};
+
+// lock-free union-find for dense vertex ids 0..N-1 which can be used by many
+// threads at once, in the style of Anderson-Woll and Jayanti-Tarjan.
+// the parent of each vertex is an atomic slot, and all updates are CAS:
+// - find: path halving, i.e. try to CAS each vertex on the path from its
+//   parent to its grandparent. a failed CAS only means another thread has
+//   already changed the slot, so it's simply skipped.
+// - union: find both roots and CAS the root with the lower priority from
+//   itself to the other root. the CAS fails iff that root has been linked
+//   meanwhile, in which case the union is retried from the new roots.
+// linking by a fixed total order of priorities never forms a cycle. the
+// priorities are a hash of the vertex ids, which breaks up adversarial id
+// orders as the randomized linking of Jayanti-Tarjan does.
+// note, union by rank is not used since the rank of a root cannot be updated
+// together with its parent in one CAS.
+// it keeps no AlgoStats, whose counters all threads would contend on.
+class ConcurrentUF {
+ public:
+  explicit ConcurrentUF(const int n) : p(n), cc_cnt{n} {
+    for (int v = 0; v < n; ++v) {
+      p[v].store(v, std::memory_order_relaxed);
+    }
+  }
+
+  int size() const { return static_cast<int>(p.size()); }
+
+  int find(int id) {
+    while (true) {
+      int parent = p[id].load(std::memory_order_acquire);
+      if (parent == id) {
+        return id;
+      }
+      const int grand = p[parent].load(std::memory_order_acquire);
+      if (grand != parent) {
+        // path halving. it's fine to lose the race.
+        p[id].compare_exchange_weak(parent, grand, std::memory_order_acq_rel);
+      }
+      id = grand;
+    }
+  }
+
+  /// @return false if they are already connected.
+  bool union_vertices(int v, int w) {
+    while (true) {
+      v = find(v);
+      w = find(w);
+      if (v == w) {
+        return false;
+      }
+      if (lower(w, v)) {
+        std::swap(v, w);
+      }
+      // link the lower priority root v under w.
+      int expected = v;
+      if (p[v].compare_exchange_strong(expected, w,
+                                       std::memory_order_acq_rel)) {
+        cc_cnt.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+
+  bool is_connected(int v, int w) {
+    while (true) {
+      v = find(v);
+      w = find(w);
+      if (v == w) {
+        return true;
+      }
+      // v was a root when found. if it still is, then v and w were in
+      // different trees at that moment.
+      if (p[v].load(std::memory_order_acquire) == v) {
+        return false;
+      }
+    }
+  }
+
+  int get_cc_cnt() const { return cc_cnt.load(std::memory_order_relaxed); }
+
+ private:
+  // return true if the vertex v has lower priority than the vertex w.
+  static bool lower(const int v, const int w) {
+    const uint64_t hv = mix(v);
+    const uint64_t hw = mix(w);
+    return hv != hw ? hv < hw : v < w;
+  }
+
+  // the splitmix64 finalizer.
+  static uint64_t mix(const int v) {
+    uint64_t x = static_cast<uint32_t>(v) + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  // key: vertex id, value: parent's vertex id.
+  std::vector<std::atomic<int>> p;
+  // #connected components.
+  std::atomic<int> cc_cnt;
+};
+
+class CsrGraph;
+
+// create a union-find over all vertices of the graph, picking the flat DenseUF
+// for the dense indices of a CsrGraph and the map-backed UF otherwise.
+/// @param resource for the maps of a UF.
+template <typename G>
+auto make_uf(const G& g, std::pmr::memory_resource* const resource =
+                             std::pmr::get_default_resource()) {
+  if constexpr (std::is_same_v<G, CsrGraph>) {
+    return DenseUF(g.num_vertices());
+  } else {
+    return UF(g.all_vertices(), resource);
+  }
+}
+
 #endif  // UNION_FIND_HPP_
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef WORKSPACE_HPP_
+#define WORKSPACE_HPP_
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "stats.hpp"
+
+// reusable scratch memory for the algorithms on a Graph, whose visited sets
+// and parent/distance maps are hash containers allocating one node per entry.
+// the containers of a query are allocated from the pool of a workspace
+// instead of the global heap. when the query ends, the nodes go back to the
+// pool rather than to malloc, so once a thread's first queries have grown the
+// pool, its later queries allocate nothing from the heap. and the pool is not
+// synchronized, so the query threads don't contend on the allocator.
+// a workspace must be used by one thread at a time. for_this_thread() gives
+// each thread its own.
+// the algorithms taking one are the SSSP/APSP ones of shortest_path.hpp,
+// Prim, the DFS and union-find CCs, Kosaraju, the DFS and BFS topological
+// sorts and the DFS cycle detections. the DFS based ones also take their CSR
+// snapshot of a Graph from the workspace. what they return, e.g. the tree of
+// Prim or the components, is still on the heap. Kruskal and uf_detect_cycle
+// don't take one yet, since they sort and dedup a copy of the edge list.
+// note, the algorithms on a CsrGraph keep flat arrays for the same purpose,
+// e.g. DijkstraWorkspace.
+// the algorithms returning no result struct leave their AlgoStats in the
+// workspace, see stats.hpp.
+class Workspace {
+ public:
+  // blocks up to this size are pooled. larger ones, e.g. the bucket arrays of
+  // huge hash maps, go to the upstream resource.
+  static constexpr std::size_t LARGEST_POOLED_BLOCK = 1 << 20;
+
+  Workspace() : Workspace(std::pmr::get_default_resource()) {}
+  explicit Workspace(std::pmr::memory_resource* const upstream)
+      : pool(std::pmr::pool_options{.max_blocks_per_chunk = 0,
+                                    .largest_required_pool_block =
+                                        LARGEST_POOLED_BLOCK},
+             upstream) {}
+  Workspace(const Workspace&) = delete;
+  Workspace& operator=(const Workspace&) = delete;
+
+  std::pmr::memory_resource* resource() { return &pool; }
+
+  // return all memory to the upstream, e.g. after an unusually large query.
+  // no container allocated from this workspace may be alive.
+  void release() { pool.release(); }
+
+  // the stats of the last query run on this workspace.
+  AlgoStats& stats() { return stats_; }
+
+  // the workspace of the calling thread.
+  static Workspace& for_this_thread() {
+    thread_local Workspace ws;
+    return ws;
+  }
+
+ private:
+  std::pmr::unsynchronized_pool_resource pool;
+  [[no_unique_address]] AlgoStats stats_;
+};
+
+#endif  // WORKSPACE_HPP_